@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "util.h"
+
+ARENA*
+ARENA_constructor(ARENA *self, size_t chunk_sz)
+/***********************************************
+ * Construct an ARENA.
+ */
+{
+   if(!self) return NULL;
+   memset(self, 0, sizeof(*self));
+   self->chunk_sz= chunk_sz;
+   return self;
+}
+
+void*
+ARENA_destructor(ARENA *self)
+/***********************************************
+ * Destruct an ARENA.
+ */
+{
+   struct arena_chunk *chunk;
+   while((chunk= self->head)) {
+      self->head= chunk->next;
+      free(chunk);
+   }
+   self->cur= NULL;
+   self->pos= NULL;
+   return self;
+}
+
+static void*
+grow(ARENA *self, size_t sz)
+/***********************************************
+ * Move on to a chunk with room for sz bytes,
+ * reusing the next one if it is big enough, and
+ * carve sz bytes out of it.
+ */
+{
+   struct arena_chunk *next= self->cur ? self->cur->next : self->head;
+
+   if(!next || next->sz < sz) {
+
+      size_t chunk_sz= sz > self->chunk_sz ? sz : self->chunk_sz;
+      struct arena_chunk *chunk= malloc(sizeof(*chunk) + chunk_sz);
+      if(!chunk) {
+         sys_eprintf("ERROR: malloc(%zu) failed", sizeof(*chunk) + chunk_sz);
+         return NULL;
+      }
+      chunk->sz= chunk_sz;
+      chunk->end= chunk->mem + chunk_sz;
+
+      /* Slip it in ahead of any chunks too small to use */
+      chunk->next= next;
+      if(self->cur)
+         self->cur->next= chunk;
+      else
+         self->head= chunk;
+      next= chunk;
+   }
+
+   self->cur= next;
+   self->pos= next->mem + sz;
+   return next->mem;
+}
+
+void*
+ARENA_alloc(ARENA *self, size_t sz)
+/***********************************************
+ * Get sz bytes.
+ */
+{
+   /* Round up, so everything stays aligned */
+   sz= (sz + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+   if(self->cur && (size_t)(self->cur->end - self->pos) >= sz) {
+      void *rtn= self->pos;
+      self->pos += sz;
+      return rtn;
+   }
+
+   return grow(self, sz);
+}
+
+char*
+ARENA_strndup(ARENA *self, const char *src, size_t len)
+/***********************************************
+ * Copy len bytes of src into the arena.
+ */
+{
+   char *rtn= ARENA_alloc(self, len + 1);
+   if(!rtn) return NULL;
+
+   memcpy(rtn, src, len);
+   rtn[len]= '\0';
+   return rtn;
+}
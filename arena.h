@@ -0,0 +1,95 @@
+/************************************************************
+ * Class for a bump allocator, for things which all go away
+ * at once.
+ *
+ * Memory comes from a list of chunks. Allocating bumps a
+ * pointer along the current chunk, moving on to the next one
+ * (or a new one) when it is full. ARENA_reset() rewinds to the
+ * first chunk, keeping them all, so once an arena has grown to
+ * fit its biggest load it makes no more heap calls.
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* Everything handed out is aligned to this */
+#define ARENA_ALIGN 16
+
+struct arena_chunk {
+   struct arena_chunk *next;
+   size_t sz;
+   char *end;
+   _Alignas(ARENA_ALIGN) char mem[];
+};
+
+typedef struct _ARENA {
+
+   /* All the chunks, and the one being allocated from */
+   struct arena_chunk *head,
+                      *cur;
+
+   /* Next free byte in cur */
+   char *pos;
+
+   /* Size of new chunks */
+   size_t chunk_sz;
+
+} ARENA;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ARENA_create(p, chunk_sz) \
+  ((p)=(ARENA_constructor((p)=malloc(sizeof(ARENA)), chunk_sz) ? (p) : ( p ? realloc(ARENA_destructor(p),0) : 0 )))
+ARENA*
+ARENA_constructor(ARENA *self, size_t chunk_sz);
+/***********************************************
+ * Construct an ARENA, which gets memory chunk_sz
+ * bytes at a time. Nothing is allocated until it
+ * is needed.
+ *
+ * returns - pointer to the object, or NULL for failure.
+ */
+
+void*
+ARENA_destructor(ARENA *self);
+/***********************************************
+ * Destruct an ARENA, freeing all of its memory.
+ */
+
+#define ARENA_destroy(p) \
+  do {if(ARENA_destructor(p)) {free(p); p= NULL;}} while(0)
+
+void*
+ARENA_alloc(ARENA *self, size_t sz);
+/***********************************************
+ * Get sz bytes, good until the next ARENA_reset().
+ *
+ * returns - the memory, or NULL for failure.
+ */
+
+char*
+ARENA_strndup(ARENA *self, const char *src, size_t len);
+/***********************************************
+ * Copy len bytes of src into the arena, with a
+ * terminating null.
+ *
+ * returns - the copy, or NULL for failure.
+ */
+
+#define ARENA_reset(self) \
+   ((self)->pos= ((self)->cur= (self)->head) ? (self)->head->mem : NULL)
+/***********************************************
+ * void ARENA_reset(ARENA *self);
+ * Free everything allocated from the arena at once,
+ * keeping the memory for reuse.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
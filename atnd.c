@@ -1,14 +1,15 @@
+#include <ctype.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "atnd.h"
 #include "ez_libc.h"
 #include "util.h"
-#include "vcalendar.h"
 
 ATND*
-ATND_constructor (ATND * self, const char *src)
+ATND_arena_create(ARENA *arena, const char *src)
 /***********************************************
- * Construct a ATND.
+ * Construct an ATND in arena.
  *
  * src is the string with attendee information.
  * returns - pointer to the object, or NULL for failure.
@@ -16,64 +17,173 @@ ATND_constructor (ATND * self, const char *src)
 {
    ATND *rtn= NULL;
 
-   memset(self, 0, sizeof(*self));
+   struct ical_params prm;
+   const char *email= ical_params(src, &prm);
+   if(!email || !prm.cn.len)
+      goto abort;
+
+   const char *name= prm.cn.str;
+   size_t name_len= prm.cn.len;
+
+   /* The value is the address */
+   if(strncasecmp(email, "mailto:", 7))
+      goto abort;
+   email= skipspacec(email + 7);
 
-   const char *str= strstr(src, "CN=");
-   if(!str)
+   size_t email_len= strcspn(email, " \t\r\n\v\f");
+   if(!email_len)
       goto abort;
 
-   int rc= sscanf(str + 3, "%63[^:]:MAILTO:%127s", self->name, self->email);
-   if(2 != rc) {
-      rc= sscanf(str + 3, "%63[^:]:mailto:%127s", self->name, self->email);
-      if(2 != rc)
-         goto abort;
+   ATND *atnd= ARENA_alloc(arena, sizeof(*atnd) + name_len + 1 + email_len + 1);
+   if(!atnd)
+      return NULL;
+
+   atnd->flags= 0;
+   atnd->keyArr[0]= atnd->keyArr[1]= 0;
+   memcpy(atnd->text, name, name_len);
+   atnd->text[name_len]= '\0';
+   atnd->email_ndx= name_len + 1;
+   memcpy(atnd->text + atnd->email_ndx, email, email_len);
+   atnd->text[atnd->email_ndx + email_len]= '\0';
+
+   /* Fold the first 16 bytes of the name into the key */
+   unsigned i;
+   for(i= 0; i < 16; ++i) {
+      uint64_t *key= atnd->keyArr + i / 8;
+      *key <<= 8;
+      if(i < name_len)
+         *key |= (unsigned char)tolower((unsigned char)name[i]);
    }
 
    /* Note required participants */
-   if(strstr(src, "REQ-PARTICIPANT"))
-      self->flags |= ATND_REQD_FLG;
+   if(ical_slice_is(&prm.role, "REQ-PARTICIPANT"))
+      atnd->flags |= ATND_REQD_FLG;
 
-   rtn= self;
+   rtn= atnd;
 abort:
    if(!rtn)
       eprintf("ERROR: cannot extract attendee from  \"%s\"", src);
    return rtn;
 }
 
-void*
-ATND_destructor (ATND * self)
+int
+ATND_render(const ATND *self, STR *sb, const char *bold, const char *normal)
 /***********************************************
- * Destruct a ATND.
+ * Append Attendee information for report to sb.
  */
 {
-   return self;
+   const char *reqd= bold[0] ? bold : "*";
+
+   if(-1 == STR_sprintf(sb, "\t%s%s%s <%s>\n"
+         , self->flags & ATND_REQD_FLG ? reqd : ""
+         , ATND_name(self)
+         , normal
+         , ATND_email(self)
+         ))
+      return -1;
+
+   return 0;
 }
 
-int
-ATND_report(ATND *self, FILE *fh)
+/* What ATND_sort() sorts */
+struct sort_pair {
+   uint64_t keyArr[2];
+   ATND *atnd;
+};
+
+static inline int
+pair_le(const struct sort_pair *p1, const struct sort_pair *p2)
 /***********************************************
- * Print out Attendee information for report
+ * Does p1 sort before p2, or tie with it? Only
+ * when the keys are equal is there any need to
+ * compare names.
  */
 {
-   const char *reqd= G.BOLD[0] ? G.BOLD : "*";
+   if(p1->keyArr[0] != p2->keyArr[0])
+      return p1->keyArr[0] < p2->keyArr[0];
+   if(p1->keyArr[1] != p2->keyArr[1])
+      return p1->keyArr[1] < p2->keyArr[1];
 
-   ez_fprintf(fh, "\t%s%s%s <%s>\n"
-         , self->flags & ATND_REQD_FLG ? reqd : ""
-         , self->name
-         , G.NORMAL
-         , self->email
-         );
-   return 0;
+   /* Equal keys for names under 16 bytes mean equal names */
+   if(!(p1->keyArr[1] & 0xff))
+      return 1;
+
+   /* Otherwise the first 16 bytes match already */
+   return 0 >= strcasecmp(ATND_name(p1->atnd) + 16, ATND_name(p2->atnd) + 16);
 }
 
 int
-ATND_ptrvec_cmp(const void *const* pp1, const void *const* pp2)
+ATND_sort(PTRVEC *vec, ARENA *arena)
 /***********************************************
- * Comparision function for PTRVEC_sort()
+ * Stable sort of vec by name.
  */
 {
-   const ATND *a1= *(const ATND *const*)pp1,
-              *a2= *(const ATND *const*)pp2;
+   unsigned n= PTRVEC_numItems(vec);
+   if(2 > n)
+      return 0;
+
+   struct sort_pair *src= ARENA_alloc(arena, 2 * n * sizeof(*src)),
+                    *dst= src + n;
+   if(!src)
+      return -1;
+
+   unsigned i;
+   ATND *atnd;
+   void **arr= PTRVEC_contig(vec);
+   for(i= 0; i < n; ++i) {
+      atnd= arr ? arr[i] : PTRVEC_ndxPtr(vec, i);
+      src[i].keyArr[0]= atnd->keyArr[0];
+      src[i].keyArr[1]= atnd->keyArr[1];
+      src[i].atnd= atnd;
+   }
+
+   /*--- Insertion sort runs of 16, which fit in a cache line or four ---*/
+   const unsigned RUN= 16;
+   for(i= 0; i < n; i += RUN) {
+      unsigned end= i + RUN < n ? i + RUN : n,
+               j;
+      for(j= i + 1; j < end; ++j) {
+         struct sort_pair tmp= src[j];
+         unsigned k= j;
+         for(; k > i && !pair_le(src + k - 1, &tmp); --k)
+            src[k]= src[k-1];
+         src[k]= tmp;
+      }
+   }
+
+   /*--- Then merge pairs of runs, back and forth ---*/
+   unsigned width;
+   for(width= RUN; width < n; width *= 2) {
 
-   return strcasecmp(a1->name, a2->name);
+      for(i= 0; i < n; i += 2 * width) {
+         unsigned mid= i + width < n ? i + width : n,
+                  end= i + 2 * width < n ? i + 2 * width : n,
+                  l= i,
+                  r= mid,
+                  o= i;
+
+         /* Already in order? */
+         if(mid == end || pair_le(src + mid - 1, src + mid)) {
+            memcpy(dst + i, src + i, (end - i) * sizeof(*src));
+            continue;
+         }
+
+         while(l < mid && r < end)
+            dst[o++]= pair_le(src + l, src + r) ? src[l++] : src[r++];
+         while(l < mid)
+            dst[o++]= src[l++];
+         while(r < end)
+            dst[o++]= src[r++];
+      }
+
+      struct sort_pair *tmp= src;
+      src= dst;
+      dst= tmp;
+   }
+
+   PTRVEC_reset(vec);
+   for(i= 0; i < n; ++i)
+      PTRVEC_addTail(vec, src[i].atnd);
+
+   return 0;
 }
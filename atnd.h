@@ -1,17 +1,35 @@
 /************************************************************
  * Class to help with printing out attendees.
+ *
+ * An ATND is a variable length record, built in an ARENA: a
+ * small header, then the name and email, each null terminated.
+ * The header holds a collation key, so sorting by name seldom
+ * needs to look at the names themselves.
  */
 #ifndef ATND_H
 #define ATND_H
 
+#include <stdint.h>
+
+#include "arena.h"
+#include "ptrvec.h"
+#include "str.h"
 
 typedef struct _ATND {
    enum {
       ATND_REQD_FLG=1<<0
    } flags;
 
-   char name[64],
-        email[128];
+   /* Where the email begins in text */
+   unsigned email_ndx;
+
+   /* First 16 bytes of the name, case folded, as two big endian
+    * numbers; names with different keys sort in key order.
+    */
+   uint64_t keyArr[2];
+
+   /* The name, then the email */
+   char text[];
 } ATND;
 
 #ifdef __cplusplus
@@ -19,39 +37,49 @@ extern "C"
 {
 #endif
 
-#define ATND_create(p, initMaxItems) \
-  ((p)=(ATND_constructor((p)=malloc(sizeof(ATND)), initMaxItems) ? (p) : ( p ? realloc(ATND_destructor(p),0) : 0 )))
-ATND*
-ATND_constructor (ATND * self, const char *src);
+#define ATND_name(self) \
+  ((const char*)(self)->text)
 /***********************************************
- * Construct a ATND.
- *
- * src is the string with attendee information.
- * returns - pointer to the object, or NULL for failure.
+ * const char* ATND_name(const ATND *self);
+ * The attendee's name.
  */
 
+#define ATND_email(self) \
+  ((const char*)(self)->text + (self)->email_ndx)
+/***********************************************
+ * const char* ATND_email(const ATND *self);
+ * The attendee's email address.
+ */
 
-void*
-ATND_destructor (ATND * self);
+ATND*
+ATND_arena_create(ARENA *arena, const char *src);
 /***********************************************
- * Destruct a ATND.
+ * Construct an ATND in arena. There is nothing to
+ * destroy; it goes when the arena is reset.
+ *
+ * src is the string with attendee information.
+ * returns - pointer to the object, or NULL for failure.
  */
 
 int
-ATND_report(ATND *self, FILE *fh);
+ATND_render(const ATND *self, STR *sb, const char *bold, const char *normal);
 /***********************************************
- * Print out Attendee information for report
+ * Append Attendee information for report to sb.
+ * bold and normal are the terminal escape codes
+ * used to highlight required attendees, if any.
  */
 
 int
-ATND_ptrvec_cmp(const void *const* pp1, const void *const* pp2);
+ATND_sort(PTRVEC *vec, ARENA *arena);
 /***********************************************
- * Comparision function for PTRVEC_sort()
+ * Sort vec, which holds ATND objects, by name,
+ * ignoring case. Attendees with the same name keep
+ * their order. Keys are compared instead of names
+ * where they differ. Scratch space comes from arena.
+ *
+ * returns - 0 for success, -1 for error.
  */
 
-#define ATND_destroy(p) \
-  do {if(ATND_destructor(p)) {free(p); p= NULL;}} while(0)
-
 #ifdef __cplusplus
 }
 #endif
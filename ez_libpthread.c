@@ -88,6 +88,38 @@ ez_proto (int, pthread_cond_signal, pthread_cond_t *cond)
    abort();
 }
 
+/***************************************************/
+ez_proto (int, pthread_cond_broadcast, pthread_cond_t *cond)
+{
+   int rtn= pthread_cond_broadcast (cond);
+   if(0 == rtn) return 0;
+
+   errno= rtn;
+   _sys_eprintf((const char*(*)(int))strerror
+#ifdef DEBUG
+      , fileName, lineNo, funcName
+#endif
+            , "pthread_cond_broadcast() failed");
+   abort();
+}
+
+/***************************************************/
+ez_proto (int, pthread_once,
+      pthread_once_t *once_control,
+      void (*init_routine)(void))
+{
+   int rtn= pthread_once (once_control, init_routine);
+   if(0 == rtn) return 0;
+
+   errno= rtn;
+   _sys_eprintf((const char*(*)(int))strerror
+#ifdef DEBUG
+      , fileName, lineNo, funcName
+#endif
+            , "pthread_once() failed");
+   abort();
+}
+
 /***************************************************/
 ez_proto (int, pthread_cond_wait,
       pthread_cond_t *cond,
@@ -122,3 +154,60 @@ ez_proto (int, pthread_join,
    abort();
 }
 
+/***************************************************/
+ez_proto (int, sem_wait,
+      sem_t *sem)
+{
+   errno= 0;
+   int rtn= sem_wait (sem);
+   if(0 == rtn) return 0;
+
+   switch(errno) {
+      case EINTR:
+         return rtn;
+   }
+
+   _sys_eprintf((const char*(*)(int))strerror
+#ifdef DEBUG
+      , fileName, lineNo, funcName
+#endif
+            , "sem_wait() failed");
+   abort();
+}
+
+/***************************************************/
+ez_proto (int, sem_trywait,
+      sem_t *sem)
+{
+   errno= 0;
+   int rtn= sem_trywait (sem);
+   if(0 == rtn) return 0;
+
+   switch(errno) {
+      case EAGAIN:
+      case EINTR:
+         return rtn;
+   }
+
+   _sys_eprintf((const char*(*)(int))strerror
+#ifdef DEBUG
+      , fileName, lineNo, funcName
+#endif
+            , "sem_trywait() failed");
+   abort();
+}
+
+/***************************************************/
+ez_proto (int, sem_post,
+      sem_t *sem)
+{
+   int rtn= sem_post (sem);
+   if(0 == rtn) return 0;
+
+   _sys_eprintf((const char*(*)(int))strerror
+#ifdef DEBUG
+      , fileName, lineNo, funcName
+#endif
+            , "sem_post() failed");
+   abort();
+}
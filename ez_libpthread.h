@@ -24,6 +24,7 @@
 #       define _GNU_SOURCE
 #endif
 #include <pthread.h>
+#include <semaphore.h>
 
 #include "ez.h"
 
@@ -74,6 +75,27 @@ ez_proto (int, pthread_cond_signal,
          _ez_pthread_cond_signal(__VA_ARGS__)
 #endif
 
+ez_proto (int, pthread_cond_broadcast,
+      pthread_cond_t *cond);
+#ifdef DEBUG
+#       define ez_pthread_cond_broadcast(...) \
+         _ez_pthread_cond_broadcast(__FILE__, __LINE__, __func__, ##__VA_ARGS__)
+#else
+#       define ez_pthread_cond_broadcast(...) \
+         _ez_pthread_cond_broadcast(__VA_ARGS__)
+#endif
+
+ez_proto (int, pthread_once,
+      pthread_once_t *once_control,
+      void (*init_routine)(void));
+#ifdef DEBUG
+#       define ez_pthread_once(...) \
+         _ez_pthread_once(__FILE__, __LINE__, __func__, ##__VA_ARGS__)
+#else
+#       define ez_pthread_once(...) \
+         _ez_pthread_once(__VA_ARGS__)
+#endif
+
 ez_proto (int, pthread_cond_wait,
       pthread_cond_t *cond,
       pthread_mutex_t *mutex);
@@ -96,6 +118,36 @@ ez_proto (int, pthread_join,
          _ez_pthread_join(__VA_ARGS__)
 #endif
 
+ez_proto (int, sem_wait,
+      sem_t *sem);
+#ifdef DEBUG
+#       define ez_sem_wait(...) \
+         _ez_sem_wait(__FILE__, __LINE__, __func__, ##__VA_ARGS__)
+#else
+#       define ez_sem_wait(...) \
+         _ez_sem_wait(__VA_ARGS__)
+#endif
+
+ez_proto (int, sem_trywait,
+      sem_t *sem);
+#ifdef DEBUG
+#       define ez_sem_trywait(...) \
+         _ez_sem_trywait(__FILE__, __LINE__, __func__, ##__VA_ARGS__)
+#else
+#       define ez_sem_trywait(...) \
+         _ez_sem_trywait(__VA_ARGS__)
+#endif
+
+ez_proto (int, sem_post,
+      sem_t *sem);
+#ifdef DEBUG
+#       define ez_sem_post(...) \
+         _ez_sem_post(__FILE__, __LINE__, __func__, ##__VA_ARGS__)
+#else
+#       define ez_sem_post(...) \
+         _ez_sem_post(__VA_ARGS__)
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,447 @@
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define HAVE_X86 1
+#endif
+
+#include "ez_libc.h"
+#include "ez_libpthread.h"
+#include "inbuf.h"
+#include "util.h"
+
+/* Unfolds the logical line starting at p in place */
+typedef char *(*unfold_fn)(char *p, char *end, char **wr_end);
+
+static char *unfold_scalar(char *p, char *end, char **wr_end);
+static void unfold_init(void);
+
+/* Line unfolder chosen for this CPU */
+static unfold_fn Unfold= unfold_scalar;
+static pthread_once_t Unfold_once= PTHREAD_ONCE_INIT;
+
+INBUF*
+INBUF_constructor(INBUF *self)
+/***********************************************
+ * Construct an INBUF.
+ */
+{
+   memset(self, 0, sizeof(*self));
+   ez_pthread_once(&Unfold_once, unfold_init);
+   return self;
+}
+
+void*
+INBUF_destructor(INBUF *self)
+/***********************************************
+ * Destruct an INBUF.
+ */
+{
+   INBUF_close(self);
+   if(self->rd_buf) free(self->rd_buf);
+   return self;
+}
+
+static int
+reserve(INBUF *self, size_t sz)
+/***********************************************
+ * Make sure rd_buf can hold at least sz bytes.
+ * Returns 0 for success, -1 for error.
+ */
+{
+   if(sz <= self->rd_sz)
+      return 0;
+
+   size_t new_sz= self->rd_sz ? self->rd_sz : 4096;
+   while(new_sz < sz)
+      new_sz *= 2;
+
+   char *p= realloc(self->rd_buf, new_sz);
+   if(!p) {
+      sys_eprintf("ERROR: realloc(%zu) failed", new_sz);
+      return -1;
+   }
+
+   self->rd_buf= p;
+   self->rd_sz= new_sz;
+   return 0;
+}
+
+int
+INBUF_open(INBUF *self, const char *path)
+/***********************************************
+ * Load the file path ("-" for stdin).
+ */
+{
+   int rtn= -1;
+
+   if(!strcmp(path, "-"))
+      return INBUF_openFd(self, STDIN_FILENO);
+
+   int fd= open(path, O_RDONLY);
+   if(-1 == fd) {
+      sys_eprintf("ERROR: open(\"%s\") failed", path);
+      goto abort;
+   }
+
+   rtn= INBUF_openFd(self, fd);
+   ez_close(fd);
+
+abort:
+   return rtn;
+}
+
+int
+INBUF_openFd(INBUF *self, int fd)
+/***********************************************
+ * Load whatever can be read from fd.
+ */
+{
+   int rtn= -1;
+   struct stat st;
+
+   INBUF_close(self);
+
+   if(-1 == fstat(fd, &st)) {
+      sys_eprintf("ERROR: fstat() failed");
+      goto abort;
+   }
+
+   if(S_ISREG(st.st_mode) && st.st_size) {
+
+      size_t pg_sz= sysconf(_SC_PAGESIZE);
+
+      /* We need one byte past the end for a terminating null. Unless the
+       * input ends with a newline, that byte must fall on the last mapped
+       * page.
+       */
+      if(st.st_size % pg_sz) {
+
+         /* Private & writable, so lines can be unfolded in place */
+         char *p= mmap(NULL, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+         if(MAP_FAILED != p) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            self->buf= p;
+            self->len= self->map_sz= st.st_size;
+            rtn= 0;
+            goto abort;
+         }
+      }
+   }
+
+   /*--- Read everything into rd_buf ---*/
+   size_t len= 0;
+   for(;;) {
+
+      if(reserve(self, len + 4096 + 1))
+         goto abort;
+
+      ssize_t rc= read(fd, self->rd_buf + len, self->rd_sz - len - 1);
+      if(-1 == rc) {
+         if(EINTR == errno) continue;
+         sys_eprintf("ERROR: read() failed");
+         goto abort;
+      }
+
+      if(!rc) break;
+      len += rc;
+   }
+
+   self->buf= self->rd_buf;
+   self->len= len;
+
+   rtn= 0;
+abort:
+   return rtn;
+}
+
+int
+INBUF_openBuf(INBUF *self, const char *buf, size_t buf_len)
+/***********************************************
+ * Load a copy of buf.
+ */
+{
+   INBUF_close(self);
+
+   if(reserve(self, buf_len + 1))
+      return -1;
+
+   memcpy(self->rd_buf, buf, buf_len);
+   self->buf= self->rd_buf;
+   self->len= buf_len;
+
+   return 0;
+}
+
+int
+INBUF_openRegion(INBUF *self, char *buf, size_t len)
+/***********************************************
+ * Use buf[len] in place.
+ */
+{
+   INBUF_close(self);
+
+   self->buf= buf;
+   self->len= len;
+
+   return 0;
+}
+
+size_t
+INBUF_findLine(const INBUF *self, size_t from, const char *line)
+/***********************************************
+ * Find the next line which is exactly line.
+ */
+{
+   const char *buf= self->buf,
+              *end= buf + self->len;
+   size_t line_len= strlen(line);
+
+   const char *p= buf + from;
+
+   /* from only starts a line if it follows a newline */
+   if(from && p < end && '\n' != p[-1]) {
+      if(!(p= memchr(p, '\n', end - p)))
+         return self->len;
+      ++p;
+   }
+
+   while(p < end) {
+
+      if((size_t)(end - p) >= line_len && !memcmp(p, line, line_len)) {
+         const char *q= p + line_len;
+         if(q == end || '\n' == *q || ('\r' == *q && (q + 1 == end || '\n' == q[1])))
+            return p - buf;
+      }
+
+      if(!(p= memchr(p, '\n', end - p)))
+         break;
+      ++p;
+   }
+
+   return self->len;
+}
+
+void
+INBUF_close(INBUF *self)
+/***********************************************
+ * Release the current input.
+ */
+{
+   if(self->map_sz)
+      munmap(self->buf, self->map_sz);
+
+   self->buf= NULL;
+   self->len= self->pos= self->map_sz= 0;
+}
+
+static inline int
+is_fold(char c)
+/***********************************************
+ * Does a line starting with c continue the one
+ * before it?
+ */
+{
+   return ' ' == c || '\t' == c;
+}
+
+static inline char*
+slide(char *wr, char *from, char *to)
+/***********************************************
+ * Move [from, to) down to wr, returning the end
+ * of where it went.
+ */
+{
+   if(wr != from)
+      memmove(wr, from, to - from);
+   return wr + (to - from);
+}
+
+static inline char*
+fold_at(char *wr, char *seg, char *nl)
+/***********************************************
+ * Move the physical line [seg, nl) down to wr,
+ * without the carriage return before nl.
+ */
+{
+   if(nl > seg && '\r' == nl[-1])
+      --nl;
+   return slide(wr, seg, nl);
+}
+
+static char*
+unfold_tail(char *p, char *end, char *seg, char *wr, char **wr_end)
+/***********************************************
+ * Carry on unfolding from p, one newline at a
+ * time. seg is where the current physical line
+ * began, and wr where it goes.
+ */
+{
+   for(;;) {
+      char *nl= memchr(p, '\n', end - p);
+      if(!nl || nl + 1 == end || !is_fold(nl[1])) {
+         char *lend= nl ? nl : end;
+         *wr_end= slide(wr, seg, lend);
+         return lend;
+      }
+      wr= fold_at(wr, seg, nl);
+      seg= p= nl + 2;
+   }
+}
+
+static char*
+unfold_scalar(char *p, char *end, char **wr_end)
+/***********************************************
+ * Find the newline ending the logical line which
+ * starts at p, or end if there is none, sliding
+ * continuations down over the line breaks. The
+ * end of the unfolded text goes in *wr_end.
+ */
+{
+   return unfold_tail(p, end, p, p, wr_end);
+}
+
+#ifdef HAVE_X86
+/* Each block compares the bytes at p against '\n', and the bytes at
+ * p + 1 against ' ' and '\t'. A newline ends the line unless the
+ * byte after it is a space or tab. Nothing is written past the newline
+ * being handled, so blocks already loaded are never stale.
+ */
+
+__attribute__((target("sse2")))
+static char*
+unfold_sse2(char *p, char *end, char **wr_end)
+/***********************************************
+ * unfold_scalar(), 16 bytes at a time.
+ */
+{
+   const __m128i nl= _mm_set1_epi8('\n'),
+                 sp= _mm_set1_epi8(' '),
+                 ht= _mm_set1_epi8('\t');
+   char *seg= p,
+        *wr= p;
+
+   /* Leave room for the byte after the block */
+   for(; end - p > 16; p += 16) {
+
+      __m128i here= _mm_loadu_si128((const __m128i*)p),
+              next= _mm_loadu_si128((const __m128i*)(p + 1));
+
+      unsigned nl_mask= _mm_movemask_epi8(_mm_cmpeq_epi8(here, nl));
+      if(!nl_mask)
+         continue;
+
+      unsigned fold_mask= nl_mask & _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(next, sp), _mm_cmpeq_epi8(next, ht))),
+               end_mask= nl_mask & ~fold_mask,
+               ndx= end_mask ? __builtin_ctz(end_mask) : 16;
+
+      fold_mask &= (1u << ndx) - 1;
+      while(fold_mask) {
+         char *at= p + __builtin_ctz(fold_mask);
+         wr= fold_at(wr, seg, at);
+         seg= at + 2;
+         fold_mask &= fold_mask - 1;
+      }
+
+      if(end_mask) {
+         *wr_end= slide(wr, seg, p + ndx);
+         return p + ndx;
+      }
+   }
+
+   return unfold_tail(p, end, seg, wr, wr_end);
+}
+
+__attribute__((target("avx2")))
+static char*
+unfold_avx2(char *p, char *end, char **wr_end)
+/***********************************************
+ * unfold_scalar(), 32 bytes at a time.
+ */
+{
+   const __m256i nl= _mm256_set1_epi8('\n'),
+                 sp= _mm256_set1_epi8(' '),
+                 ht= _mm256_set1_epi8('\t');
+   char *seg= p,
+        *wr= p;
+
+   for(; end - p > 32; p += 32) {
+
+      __m256i here= _mm256_loadu_si256((const __m256i*)p),
+              next= _mm256_loadu_si256((const __m256i*)(p + 1));
+
+      unsigned nl_mask= _mm256_movemask_epi8(_mm256_cmpeq_epi8(here, nl));
+      if(!nl_mask)
+         continue;
+
+      unsigned fold_mask= nl_mask & _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(next, sp), _mm256_cmpeq_epi8(next, ht))),
+               end_mask= nl_mask & ~fold_mask,
+               ndx= end_mask ? __builtin_ctz(end_mask) : 32;
+
+      if(ndx < 32)
+         fold_mask &= (1u << ndx) - 1;
+      while(fold_mask) {
+         char *at= p + __builtin_ctz(fold_mask);
+         wr= fold_at(wr, seg, at);
+         seg= at + 2;
+         fold_mask &= fold_mask - 1;
+      }
+
+      if(end_mask) {
+         *wr_end= slide(wr, seg, p + ndx);
+         return p + ndx;
+      }
+   }
+
+   return unfold_tail(p, end, seg, wr, wr_end);
+}
+#endif
+
+static void
+unfold_init(void)
+/***********************************************
+ * Pick the best line unfolder this CPU can run.
+ */
+{
+#ifdef HAVE_X86
+   __builtin_cpu_init();
+   if(__builtin_cpu_supports("avx2"))
+      Unfold= unfold_avx2;
+   else if(__builtin_cpu_supports("sse2"))
+      Unfold= unfold_sse2;
+#endif
+}
+
+char*
+INBUF_getLine(INBUF *self, size_t *len)
+/***********************************************
+ * Get the next line, with continuation lines
+ * joined, and null terminated.
+ */
+{
+   char *end= self->buf + self->len,
+        *line= self->buf + self->pos,
+        *wr;
+
+   if(line >= end)
+      return NULL;
+
+   /* Find and unfold the whole logical line in one pass */
+   char *lend= (*Unfold)(line, end, &wr);
+   self->pos= (lend < end ? lend + 1 : end) - self->buf;
+
+   /* Get rid of whitespace on the end */
+   while(wr > line && isspace((unsigned char)wr[-1]))
+      --wr;
+   *wr= '\0';
+
+   if(len) *len= wr - line;
+   return line;
+}
@@ -0,0 +1,131 @@
+/************************************************************
+ * Class to hold an entire vcalendar input in memory, and hand
+ * it out one unfolded (RFC 5545 section 3.1) line at a time.
+ *
+ * Regular files are mmap()'d; pipes and in-memory inputs are
+ * read into a buffer which is kept for the next input. Lines
+ * are unfolded in place, so they cost no copying, and have no
+ * length limit. Line ends, and whether the next line continues
+ * the current one, are found a block at a time with SSE2 or
+ * AVX2 when the CPU has them.
+ */
+#ifndef INBUF_H
+#define INBUF_H
+
+#include <stddef.h>
+
+typedef struct _INBUF {
+
+   /* The input, with room for a terminating null */
+   char *buf;
+   size_t len;
+
+   /* Where the next line begins */
+   size_t pos;
+
+   /* Nonzero when buf is mmap()'d */
+   size_t map_sz;
+
+   /* Buffer for inputs we read, reused from one input to the next */
+   char *rd_buf;
+   size_t rd_sz;
+
+} INBUF;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define INBUF_create(p) \
+  ((p)=(INBUF_constructor((p)=malloc(sizeof(INBUF))) ? (p) : ( p ? realloc(INBUF_destructor(p),0) : 0 )))
+INBUF*
+INBUF_constructor(INBUF *self);
+/***********************************************
+ * Construct an INBUF.
+ *
+ * returns - pointer to the object, or NULL for failure.
+ */
+
+void*
+INBUF_destructor(INBUF *self);
+/***********************************************
+ * Destruct an INBUF.
+ */
+
+#define INBUF_destroy(p) \
+  do {if(INBUF_destructor(p)) {free(p); p= NULL;}} while(0)
+
+int
+INBUF_open(INBUF *self, const char *path);
+/***********************************************
+ * Load the file path ("-" for stdin).
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+int
+INBUF_openFd(INBUF *self, int fd);
+/***********************************************
+ * Load whatever can be read from fd. fd is not
+ * closed.
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+int
+INBUF_openBuf(INBUF *self, const char *buf, size_t buf_len);
+/***********************************************
+ * Load a copy of buf.
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+int
+INBUF_openRegion(INBUF *self, char *buf, size_t len);
+/***********************************************
+ * Use the len bytes at buf as the input, without
+ * copying them. Lines are unfolded in place, so
+ * nothing else may use the region meanwhile, and
+ * it must stay valid until INBUF_close(). Unless
+ * the region ends with a newline, buf[len] must
+ * be writable too.
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+size_t
+INBUF_findLine(const INBUF *self, size_t from, const char *line);
+/***********************************************
+ * Find the first line which is exactly line,
+ * starting at or after offset from. Continuation
+ * lines are never matched, since they begin with
+ * whitespace.
+ *
+ * returns - the offset of the line, or the length
+ *    of the input if there is none.
+ */
+
+void
+INBUF_close(INBUF *self);
+/***********************************************
+ * Release the current input. Lines previously
+ * returned are no longer valid.
+ */
+
+char*
+INBUF_getLine(INBUF *self, size_t *len);
+/***********************************************
+ * Get the next line, with continuation lines
+ * joined, the line ending and trailing whitespace
+ * removed, and null terminated. If len is not NULL,
+ * the length of the line is stored there.
+ *
+ * returns - the line, or NULL at end of input.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
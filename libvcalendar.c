@@ -0,0 +1,152 @@
+/******************************************************************************
+ * Implementation of the stable libvcalendar interface in vcalendar.h, on top
+ * of the VCAL class.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+
+#include "atnd.h"
+#include "util.h"
+#include "vcal.h"
+#include "vcalendar.h"
+
+/* The public flag bits must track the private ones */
+_Static_assert((int)VCALENDAR_HAS_START == (int)VCAL_START_FLG &&
+               (int)VCALENDAR_HAS_END == (int)VCAL_END_FLG &&
+               (int)VCALENDAR_HAS_SUMMARY == (int)VCAL_SUMMARY_FLG &&
+               (int)VCALENDAR_HAS_LOCATION == (int)VCAL_LOCATION_FLG &&
+               (int)VCALENDAR_HAS_ORG == (int)VCAL_ORG_FLG &&
+               (int)VCALENDAR_HAS_DESC == (int)VCAL_DESC_FLG &&
+               (int)VCALENDAR_HAS_SCHED == (int)VCAL_SCHED_FLG,
+               "vcalendar_event.has bits differ from VCAL flags");
+
+void
+vcalendar_version(int *major, int *minor, int *patch)
+/***********************************************
+ * Get the version of the library actually linked.
+ */
+{
+   if(major) *major= VCALENDAR_VERSION_MAJOR;
+   if(minor) *minor= VCALENDAR_VERSION_MINOR;
+   if(patch) *patch= VCALENDAR_VERSION_PATCH;
+}
+
+VCAL*
+vcalendar_new(void)
+/***********************************************
+ * Allocate a parser context.
+ */
+{
+   VCAL *rtn;
+   return VCAL_create(rtn);
+}
+
+void
+vcalendar_free(VCAL *vc)
+/***********************************************
+ * Release a parser context.
+ */
+{
+   if(vc)
+      VCAL_destroy(vc);
+}
+
+void
+vcalendar_set_style(VCAL *vc, const char *bold, const char *rev, const char *normal)
+/***********************************************
+ * Set the terminal escape codes used to highlight
+ * rendered reports.
+ */
+{
+   VCAL_STYLE *st= &vc->style;
+
+   memset(st, 0, sizeof(*st));
+   if(bold) strncpy(st->BOLD, bold, sizeof(st->BOLD) - 1);
+   if(rev) strncpy(st->REV, rev, sizeof(st->REV) - 1);
+   if(normal) strncpy(st->NORMAL, normal, sizeof(st->NORMAL) - 1);
+}
+
+int
+vcalendar_add_zone(VCAL *vc, const char *zone)
+/***********************************************
+ * Render times in the POSIX timezone zone.
+ */
+{
+   return VCAL_addZone(vc, zone);
+}
+
+void
+vcalendar_set_event_cb(VCAL *vc, int (*cb)(VCAL *vc, void *ctxt), void *ctxt)
+/***********************************************
+ * Have cb called as each VEVENT is parsed.
+ */
+{
+   VCAL_setEventHandler(vc, cb, ctxt);
+}
+
+int
+vcalendar_parse(VCAL *vc, const char *buf, size_t buf_len)
+/***********************************************
+ * Parse a vcalendar attachment from memory.
+ */
+{
+   VCAL_reset(vc);
+   return VCAL_parseBuf(vc, buf, buf_len);
+}
+
+int
+vcalendar_event(VCAL *vc, struct vcalendar_event *rtnBuf)
+/***********************************************
+ * Fill in rtnBuf with what vcalendar_parse() found.
+ */
+{
+   memset(rtnBuf, 0, sizeof(*rtnBuf));
+
+   rtnBuf->has= vc->flags;
+   rtnBuf->start= vc->start;
+   rtnBuf->end= vc->end;
+   rtnBuf->scheduled= vc->scheduled;
+   rtnBuf->summary= vc->summary;
+   rtnBuf->location= vc->location;
+   rtnBuf->organizer= vc->organizer;
+   rtnBuf->description= vc->description;
+   rtnBuf->nAttendees= PTRVEC_numItems(&vc->attendee_vec);
+
+   return 0;
+}
+
+int
+vcalendar_attendee(VCAL *vc, unsigned ndx, const char **name, const char **email, int *is_required)
+/***********************************************
+ * Get attendee number ndx.
+ */
+{
+   ATND *atnd= PTRVEC_ndxPtr(&vc->attendee_vec, ndx);
+   if(!atnd)
+      return -1;
+
+   if(name) *name= ATND_name(atnd);
+   if(email) *email= ATND_email(atnd);
+   if(is_required) *is_required= atnd->flags & ATND_REQD_FLG ? 1 : 0;
+
+   return 0;
+}
+
+const char*
+vcalendar_render(VCAL *vc, size_t *len)
+/***********************************************
+ * Render the report for what vcalendar_parse()
+ * found.
+ */
+{
+   STR *sb= &vc->report_sb;
+   STR_reset(sb);
+
+   if(VCAL_render(vc, sb))
+      return NULL;
+
+   if(len) *len= STR_len(sb);
+   return STR_str(sb);
+}
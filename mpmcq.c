@@ -0,0 +1,197 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ez_libpthread.h"
+#include "mpmcq.h"
+#include "util.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#  define cpu_relax() __builtin_ia32_pause()
+#else
+#  define cpu_relax() ((void)0)
+#endif
+
+MPMCQ*
+MPMCQ_constructor(MPMCQ *self, unsigned maxItems)
+/***********************************************
+ * Construct an empty MPMCQ.
+ */
+{
+   MPMCQ *rtn= NULL;
+
+   if(!self) return NULL;
+   memset(self, 0, sizeof(*self));
+
+   unsigned sz= 1;
+   while(sz && sz < maxItems)
+      sz <<= 1;
+   if(!maxItems || !sz || sz > SEM_VALUE_MAX) {
+      eprintf("ERROR: bad queue size %u", maxItems);
+      goto abort;
+   }
+
+   if(!(self->cellArr= malloc(sz * sizeof(*self->cellArr)))) {
+      sys_eprintf("ERROR: malloc() failed");
+      goto abort;
+   }
+   self->maxItems= sz;
+
+   /* Cell i is first filled by the push at position i */
+   unsigned i;
+   for(i= 0; i < sz; ++i)
+      atomic_init(&self->cellArr[i].seq, i);
+   atomic_init(&self->push_pos, 0);
+   atomic_init(&self->pop_pos, 0);
+
+   if(sem_init(&self->free_sem, 0, sz) ||
+      sem_init(&self->full_sem, 0, 0))
+   {
+      sys_eprintf("ERROR: sem_init() failed");
+      goto abort;
+   }
+
+   rtn= self;
+abort:
+   return rtn;
+}
+
+void*
+MPMCQ_destructor(MPMCQ *self)
+/***********************************************
+ * Destruct an MPMCQ.
+ */
+{
+   if(self->cellArr) {
+      free(self->cellArr);
+      sem_destroy(&self->free_sem);
+      sem_destroy(&self->full_sem);
+   }
+   return self;
+}
+
+static void
+put(MPMCQ *self, void *item)
+/***********************************************
+ * Put item in the next cell. The caller holds a
+ * count from free_sem, so there is room.
+ */
+{
+   unsigned long pos= atomic_load_explicit(&self->push_pos, memory_order_relaxed);
+   struct mpmcq_cell *cell;
+
+   for(;;) {
+      cell= self->cellArr + (pos & (self->maxItems - 1));
+      unsigned long seq= atomic_load_explicit(&cell->seq, memory_order_acquire);
+      long dif= (long)(seq - pos);
+
+      if(!dif) {
+         /* Our turn; try to claim it */
+         if(atomic_compare_exchange_weak_explicit(&self->push_pos, &pos, pos + 1,
+                  memory_order_relaxed, memory_order_relaxed))
+            break;
+
+      } else if(dif < 0) {
+         /* Still being emptied by a consumer which got in ahead of us */
+         cpu_relax();
+         pos= atomic_load_explicit(&self->push_pos, memory_order_relaxed);
+
+      } else {
+         /* Another producer beat us to it */
+         pos= atomic_load_explicit(&self->push_pos, memory_order_relaxed);
+      }
+   }
+
+   cell->item= item;
+   atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+   ez_sem_post(&self->full_sem);
+}
+
+static void*
+take(MPMCQ *self)
+/***********************************************
+ * Take the item from the next cell. The caller holds
+ * a count from full_sem, so there is one.
+ */
+{
+   unsigned long pos= atomic_load_explicit(&self->pop_pos, memory_order_relaxed);
+   struct mpmcq_cell *cell;
+
+   for(;;) {
+      cell= self->cellArr + (pos & (self->maxItems - 1));
+      unsigned long seq= atomic_load_explicit(&cell->seq, memory_order_acquire);
+      long dif= (long)(seq - (pos + 1));
+
+      if(!dif) {
+         if(atomic_compare_exchange_weak_explicit(&self->pop_pos, &pos, pos + 1,
+                  memory_order_relaxed, memory_order_relaxed))
+            break;
+
+      } else if(dif < 0) {
+         /* Still being filled by a producer which got in ahead of us */
+         cpu_relax();
+         pos= atomic_load_explicit(&self->pop_pos, memory_order_relaxed);
+
+      } else {
+         pos= atomic_load_explicit(&self->pop_pos, memory_order_relaxed);
+      }
+   }
+
+   void *item= cell->item;
+
+   /* Ready for the push one lap later */
+   atomic_store_explicit(&cell->seq, pos + self->maxItems, memory_order_release);
+   ez_sem_post(&self->free_sem);
+   return item;
+}
+
+void
+MPMCQ_push(MPMCQ *self, void *item)
+/***********************************************
+ * Add item to the back, blocking while full.
+ */
+{
+   while(ez_sem_wait(&self->free_sem))
+      ;
+   put(self, item);
+}
+
+int
+MPMCQ_tryPush(MPMCQ *self, void *item)
+/***********************************************
+ * Add item to the back, if there is room.
+ */
+{
+   while(ez_sem_trywait(&self->free_sem)) {
+      if(EAGAIN == errno)
+         return -1;
+   }
+   put(self, item);
+   return 0;
+}
+
+void*
+MPMCQ_pop(MPMCQ *self)
+/***********************************************
+ * Take the item from the front, blocking while empty.
+ */
+{
+   while(ez_sem_wait(&self->full_sem))
+      ;
+   return take(self);
+}
+
+void*
+MPMCQ_tryPop(MPMCQ *self)
+/***********************************************
+ * Take the item from the front, if there is one.
+ */
+{
+   while(ez_sem_trywait(&self->full_sem)) {
+      if(EAGAIN == errno)
+         return NULL;
+   }
+   return take(self);
+}
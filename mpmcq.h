@@ -0,0 +1,112 @@
+/************************************************************
+ * Class for a bounded queue of pointers, which any number of
+ * threads may push onto and pop from at once, without a lock.
+ *
+ * Items go in a ring of cells, each with a sequence number
+ * saying whose turn it is: the producer which will fill it,
+ * or the consumer which will empty it. Producers and consumers
+ * claim positions with a compare and swap, so none of them
+ * ever waits on a mutex. A pair of counting semaphores, one
+ * for free cells and one for filled ones, lets the blocking
+ * variants sleep while the queue is full or empty, which gives
+ * upstream stages backpressure.
+ */
+#ifndef MPMCQ_H
+#define MPMCQ_H
+
+#include <semaphore.h>
+#include <stdatomic.h>
+
+/* Keep things written by different threads on different cache lines */
+#define MPMCQ_LINE_SZ 64
+
+typedef struct _MPMCQ {
+
+   /* The ring; maxItems is a power of 2 */
+   struct mpmcq_cell {
+      atomic_ulong seq;
+      void *item;
+   } *cellArr;
+   unsigned maxItems;
+
+   sem_t free_sem,   /* Counts cells free to push into */
+         full_sem;   /* Counts cells holding an item to pop */
+
+   /* Next position to push into, and to pop from, each on its own
+    * cache line. Padding rather than alignment, since malloc() won't
+    * align the object that much.
+    */
+   char pad1[MPMCQ_LINE_SZ];
+   atomic_ulong push_pos;
+   char pad2[MPMCQ_LINE_SZ - sizeof(atomic_ulong)];
+   atomic_ulong pop_pos;
+   char pad3[MPMCQ_LINE_SZ - sizeof(atomic_ulong)];
+
+} MPMCQ;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define MPMCQ_create(p, maxItems) \
+  ((p)=(MPMCQ_constructor((p)=malloc(sizeof(MPMCQ)), maxItems) ? (p) : ( p ? realloc(MPMCQ_destructor(p),0) : 0 )))
+MPMCQ*
+MPMCQ_constructor(MPMCQ *self, unsigned maxItems);
+/***********************************************
+ * Construct an empty MPMCQ.
+ *
+ * maxItems - how many items it may hold before
+ *    MPMCQ_push() blocks, rounded up to a power of 2.
+ * returns - pointer to the object, or NULL for failure.
+ */
+
+void*
+MPMCQ_destructor(MPMCQ *self);
+/***********************************************
+ * Destruct an MPMCQ. No other thread may be using it.
+ * Anything still in it is simply forgotten.
+ */
+
+#define MPMCQ_destroy(p) \
+  do {if(MPMCQ_destructor(p)) {free(p); p= NULL;}} while(0)
+
+void
+MPMCQ_push(MPMCQ *self, void *item);
+/***********************************************
+ * Add item, which must not be NULL, to the back of
+ * the queue. Blocks while the queue is full.
+ */
+
+int
+MPMCQ_tryPush(MPMCQ *self, void *item);
+/***********************************************
+ * Add item, which must not be NULL, to the back of
+ * the queue, if there is room.
+ *
+ * returns - 0 for success, nonzero if the queue is full.
+ */
+
+void*
+MPMCQ_pop(MPMCQ *self);
+/***********************************************
+ * Take the item from the front of the queue.
+ * Blocks while the queue is empty.
+ *
+ * returns - the item.
+ */
+
+void*
+MPMCQ_tryPop(MPMCQ *self);
+/***********************************************
+ * Take the item from the front of the queue, if
+ * there is one.
+ *
+ * returns - the item, or NULL if the queue is empty.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -20,37 +20,234 @@
 
 #define _GNU_SOURCE
 #include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "ptrvec.h"
 
+typedef int (*ptrvec_cmp_f) (const void *const*, const void *const*);
+
+/* Runs this short are insertion sorted before merging */
+#define SORT_RUN 16
+
+/* PTRVEC_stableSort() only gives a thread this many items or more, so
+ * starting it costs little next to the sorting; smaller vectors, such as
+ * a directory listing, are sorted without starting any threads at all.
+ */
+#define SORT_MIN_PER_THREAD 65536
+
+/* A piece of work for PTRVEC_stableSort() */
+struct sort_job
+{
+  ptrvec_cmp_f cmp;
+
+  /* Sort [lo, hi) of arr using tmp, or merge the sorted [lo, mid)
+   * and [mid, hi) of src into dst.
+   */
+  void **arr, **tmp, **src, **dst;
+  unsigned int lo, mid, hi;
+
+  pthread_t tid;
+  int is_thread;
+};
+
+
+static unsigned
+pow2 (unsigned n)
+/***********************************************
+ * Round n up to a power of 2, or 0 if it is too big.
+ */
+{
+  unsigned rtn = 1;
+  while (rtn && rtn < n)
+    rtn <<= 1;
+  return rtn;
+}
 
 static int
 grow (PTRVEC * self)
 {
-  if (PTRVEC_resize (self, self->maxItems * 2))
+  return PTRVEC_resize (self, self->maxItems * 2);
+}
+
+/* Marks an unused index entry */
+#define NDX_EMPTY (~0u)
+
+static inline unsigned int
+ndx_hash (const PTRVEC * self, const void *item)
+/***********************************************
+ * Where to start looking for item in the index.
+ */
+{
+  uint64_t h = (uintptr_t) item * 0x9E3779B97F4A7C15ull;
+  return (unsigned int) (h >> 32) & self->ndx_mask;
+}
+
+static void
+ndx_insert (PTRVEC * self, const void *item, unsigned int slot)
+/***********************************************
+ * Note that item is in slot.
+ */
+{
+  unsigned int i = ndx_hash (self, item);
+  while (NDX_EMPTY != self->ndxArr[i].slot)
+    i = (i + 1) & self->ndx_mask;
+  self->ndxArr[i].item = item;
+  self->ndxArr[i].slot = slot;
+}
+
+static struct ptrvec_slot *
+ndx_lookup (const PTRVEC * self, const void *item, unsigned int slot)
+/***********************************************
+ * Find the entry for item in slot.
+ */
+{
+  unsigned int i = ndx_hash (self, item);
+  for (; NDX_EMPTY != self->ndxArr[i].slot; i = (i + 1) & self->ndx_mask)
+    {
+      if (self->ndxArr[i].item == item && self->ndxArr[i].slot == slot)
+        return self->ndxArr + i;
+    }
+  assert (0);
+  return NULL;
+}
+
+static void
+ndx_delete (PTRVEC * self, const void *item, unsigned int slot)
+/***********************************************
+ * Forget that item is in slot. Entries further
+ * along the probe sequence are shifted back, so
+ * no tombstones are needed.
+ */
+{
+  struct ptrvec_slot *e = ndx_lookup (self, item, slot);
+  unsigned int i = e - self->ndxArr, j = i;
+
+  for (;;)
+    {
+      j = (j + 1) & self->ndx_mask;
+      if (NDX_EMPTY == self->ndxArr[j].slot)
+        break;
+
+      /* Can the entry at j move back to i? Only if it doesn't hash
+       * to somewhere in (i, j].
+       */
+      unsigned int k = ndx_hash (self, self->ndxArr[j].item);
+      if (((j - k) & self->ndx_mask) >= ((j - i) & self->ndx_mask))
+        {
+          self->ndxArr[i] = self->ndxArr[j];
+          i = j;
+        }
+    }
+  self->ndxArr[i].slot = NDX_EMPTY;
+}
+
+static void
+ndx_fill (PTRVEC * self)
+/***********************************************
+ * Rebuild the index from scratch.
+ */
+{
+  unsigned int i;
+
+  memset (self->ndxArr, 0xff, (self->ndx_mask + 1) * sizeof (*self->ndxArr));
+  for (i = 0; i < self->numItems; ++i)
+    {
+      unsigned int slot = (self->head + i) & PTRVEC_mask (self);
+      ndx_insert (self, self->ptrArr[slot], slot);
+    }
+}
+
+static void
+move_item (PTRVEC * self, unsigned int from, unsigned int to)
+/***********************************************
+ * Move the item in slot from to slot to.
+ */
+{
+  void *item = self->ptrArr[from];
+  self->ptrArr[to] = item;
+  if (self->ndxArr)
+    ndx_lookup (self, item, from)->slot = to;
+}
+
+int
+PTRVEC_index (PTRVEC * self)
+{
+  /* Keep the table no more than half full */
+  unsigned int sz = pow2 (self->maxItems * 2);
+
+  if (!sz || self->maxItems * 2 < self->maxItems)
+    return 1;
+
+  if (sz != self->ndx_mask + 1 || !self->ndxArr)
     {
-      if (PTRVEC_resize (self, self->maxItems + self->maxItems / 2))
-	{
-	  if (PTRVEC_resize (self, self->maxItems + self->maxItems / 4))
-	    return 1;
-	}
+      struct ptrvec_slot *arr = malloc (sz * sizeof (*arr));
+      if (!arr)
+        return 1;
+      if (self->ndxArr) free (self->ndxArr);
+      self->ndxArr = arr;
+      self->ndx_mask = sz - 1;
     }
+
+  ndx_fill (self);
   return 0;
 }
 
+void
+PTRVEC_clearIndex (PTRVEC * self)
+{
+  memset (self->ndxArr, 0xff, (self->ndx_mask + 1) * sizeof (*self->ndxArr));
+}
+
 int
 PTRVEC_find (const PTRVEC * self, unsigned *ndxBuf, const void *item)
 {
   unsigned int i;
   void *ptr;
+  void *const *arr = PTRVEC_contig (self);
+
+  if (self->ndxArr)
+    {
+      /* If it is there more than once, find the first */
+      unsigned int best = NDX_EMPTY, best_pos = 0;
+      for (i = ndx_hash (self, item); NDX_EMPTY != self->ndxArr[i].slot; i = (i + 1) & self->ndx_mask)
+        {
+          if (self->ndxArr[i].item != item)
+            continue;
+          unsigned int pos = (self->ndxArr[i].slot - self->head) & PTRVEC_mask (self);
+          if (NDX_EMPTY == best || pos < best_pos)
+            {
+              best = self->ndxArr[i].slot;
+              best_pos = pos;
+            }
+        }
+      if (NDX_EMPTY == best)
+        return 0;
+      if (ndxBuf) *ndxBuf = best;
+      return 1;
+    }
+
+  /* No need to wrap if the ring is in one piece */
+  if (arr)
+    {
+      for (i = 0; i < self->numItems; ++i)
+        {
+          if (arr[i] == item)
+            {
+              if(ndxBuf) *ndxBuf = self->head + i;
+              return 1;
+            }
+        }
+      return 0;
+    }
 
   PTRVEC_loopFwd (self, i, ptr)
   {
     if (ptr == item)
       {
-        if(ndxBuf) *ndxBuf = (self->head + i) % self->maxItems;
+        if(ndxBuf) *ndxBuf = (self->head + i) & PTRVEC_mask (self);
 	return 1;
       }
   }
@@ -81,6 +278,7 @@ PTRVEC_constructor (PTRVEC * self, unsigned int initMaxItems)
 {
   if (!self) return NULL;
   memset (self, 0, sizeof (*self));
+  if (!(initMaxItems = pow2 (initMaxItems))) return NULL;
   if (!(self->ptrArr = malloc (initMaxItems * sizeof (void*)))) return NULL;
 
   self->maxItems = initMaxItems;
@@ -92,40 +290,254 @@ PTRVEC_destructor (PTRVEC * self)
 {
   if (self->ptrArr) free (self->ptrArr);
   if(self->sortBuf) free(self->sortBuf);
+  if(self->ndxArr) free(self->ndxArr);
   return self;
 }
 
+static void
+reverse (void **arr, unsigned int n)
+/***********************************************
+ * Reverse arr[n] in place.
+ */
+{
+  unsigned int i;
+  for (i = 0; i < n / 2; ++i)
+    {
+      void *tmp = arr[i];
+      arr[i] = arr[n - 1 - i];
+      arr[n - 1 - i] = tmp;
+    }
+}
+
+static void **
+unwrap (PTRVEC * self)
+/***********************************************
+ * PTRVEC_unwrap(), leaving the index stale.
+ */
+{
+  if (!self->head)
+    return self->ptrArr;
+
+  if (PTRVEC_contig (self))
+    {
+      /* Just slide the items down */
+      memmove (self->ptrArr, self->ptrArr + self->head,
+               self->numItems * sizeof (*self->ptrArr));
+    }
+  else
+    {
+      /* Rotate the whole ring left by head, in place */
+      reverse (self->ptrArr, self->head);
+      reverse (self->ptrArr + self->head, self->maxItems - self->head);
+      reverse (self->ptrArr, self->maxItems);
+    }
+
+  self->head = 0;
+  self->tail = self->numItems ? self->numItems - 1 : 0;
+  return self->ptrArr;
+}
+
+void **
+PTRVEC_unwrap (PTRVEC * self)
+{
+  int moved = 0 != self->head;
+  void **rtn = unwrap (self);
+
+  if (moved && self->ndxArr)
+    ndx_fill (self);
+  return rtn;
+}
+
 int
 PTRVEC_sort (PTRVEC * self, int (*cmp) (const void *const*, const void *const*))
 {
-  void *ptr;
-  unsigned int i, sz;
-  unsigned int numItems = self->numItems;;
+  /* Nothing to sort */
+  if (self->numItems < 2) return 0;
+
+  qsort (unwrap (self), self->numItems, sizeof (void *),
+         (int(*)(const void*, const void*))cmp);
+
+  if (self->ndxArr)
+    ndx_fill (self);
+
+  return 0;
+}
+
+static void
+merge (void **src, void **dst, unsigned int lo, unsigned int mid, unsigned int hi, ptrvec_cmp_f cmp)
+/***********************************************
+ * Merge the sorted src[lo, mid) and src[mid, hi)
+ * into dst[lo, hi), taking from the left on ties.
+ */
+{
+  unsigned int l = lo, r = mid, o = lo;
+
+  /* Already in order? */
+  if (mid == hi || mid == lo || 0 >= (*cmp) ((const void *const*)(src + mid - 1), (const void *const*)(src + mid)))
+    {
+      if (src != dst)
+        memcpy (dst + lo, src + lo, (hi - lo) * sizeof (*src));
+      return;
+    }
+
+  while (l < mid && r < hi)
+    dst[o++] = 0 >= (*cmp) ((const void *const*)(src + l), (const void *const*)(src + r)) ? src[l++] : src[r++];
+  while (l < mid)
+    dst[o++] = src[l++];
+  while (r < hi)
+    dst[o++] = src[r++];
+}
+
+static void
+mergeSort (void **arr, void **tmp, unsigned int lo, unsigned int hi, ptrvec_cmp_f cmp)
+/***********************************************
+ * Stable sort of arr[lo, hi), using tmp[lo, hi)
+ * for scratch. The result ends up in arr.
+ */
+{
+  unsigned int i, j, width;
+
+  /* Insertion sort short runs */
+  for (i = lo; i < hi; i += SORT_RUN)
+    {
+      unsigned int end = i + SORT_RUN < hi ? i + SORT_RUN : hi;
+      for (j = i + 1; j < end; ++j)
+        {
+          void *item = arr[j];
+          unsigned int k = j;
+          for (; k > i && 0 < (*cmp) ((const void *const*)(arr + k - 1), (const void *const*)&item); --k)
+            arr[k] = arr[k - 1];
+          arr[k] = item;
+        }
+    }
+
+  /* Then merge them, back and forth */
+  void **src = arr, **dst = tmp;
+  for (width = SORT_RUN; width < hi - lo; width *= 2)
+    {
+      for (i = lo; i < hi; i += 2 * width)
+        {
+          unsigned int mid = i + width < hi ? i + width : hi,
+                       end = i + 2 * width < hi ? i + 2 * width : hi;
+          merge (src, dst, i, mid, end, cmp);
+        }
+      void **swap = src;
+      src = dst;
+      dst = swap;
+    }
+
+  if (src != arr)
+    memcpy (arr + lo, src + lo, (hi - lo) * sizeof (*arr));
+}
+
+static void *
+sort_job_main (void *arg)
+/***********************************************
+ * Do a piece of PTRVEC_stableSort().
+ */
+{
+  struct sort_job *job = arg;
+
+  if (job->arr)
+    mergeSort (job->arr, job->tmp, job->lo, job->hi, job->cmp);
+  else
+    merge (job->src, job->dst, job->lo, job->mid, job->hi, job->cmp);
+
+  return NULL;
+}
+
+static void
+runJobs (struct sort_job *jobArr, unsigned int nJobs)
+/***********************************************
+ * Run jobArr[nJobs] side by side, one of them on
+ * this thread, and wait for them all. Any which
+ * can't get a thread are run here too.
+ */
+{
+  unsigned int i;
+
+  for (i = 1; i < nJobs; ++i)
+    jobArr[i].is_thread = !pthread_create (&jobArr[i].tid, NULL, sort_job_main, jobArr + i);
+
+  sort_job_main (jobArr);
+
+  for (i = 1; i < nJobs; ++i)
+    {
+      if (jobArr[i].is_thread)
+        pthread_join (jobArr[i].tid, NULL);
+      else
+        sort_job_main (jobArr + i);
+    }
+}
+
+int
+PTRVEC_stableSort (PTRVEC * self, int (*cmp) (const void *const*, const void *const*), unsigned int nThreads)
+{
+  unsigned int n = self->numItems, i;
 
   /* Nothing to sort */
-  if(!numItems) return 0;
+  if (n < 2) return 0;
 
-  /* Compute how large the sort buffer needs to be */
-  sz= numItems * sizeof (void *);
+  /* Scratch space, kept for next time */
+  size_t sz = (size_t) n * sizeof (void *);
+  if (sz > self->sortBuf_sz)
+    {
+      if (self->sortBuf) free (self->sortBuf);
+      self->sortBuf_sz = 0;
+      if (!(self->sortBuf = malloc (sz))) return 1;
+      self->sortBuf_sz = sz;
+    }
 
-  /* If there is no sort buffer, or it isn't big enough, allocate more */
-  if(sz > self->sortBuf_sz) {
-    if(self->sortBuf) free(self->sortBuf);
-    self->sortBuf_sz= 0;
-    if(!(self->sortBuf= malloc(sz))) return 1;
-    self->sortBuf_sz= sz;
-  }
-//  if (!(block = malloc (numItems * sizeof (void *)))) return 1;
+  void **arr = unwrap (self),
+       **tmp = self->sortBuf;
 
+  /* A power of 2 pieces, each worth a thread */
+  unsigned int nPieces = 1;
+  while (nPieces * 2 <= nThreads && n / (nPieces * 2) >= SORT_MIN_PER_THREAD)
+    nPieces *= 2;
 
-  PTRVEC_loopFwd (self, i, ptr) self->sortBuf[i] = ptr;
-  PTRVEC_reset (self);
+  struct sort_job jobArr[nPieces];
+  memset (jobArr, 0, sizeof (jobArr));
 
-  qsort(self->sortBuf, numItems, sizeof (void *), (int(*)(const void*, const void*))cmp);
-  for (i = 0; i < numItems; i++) {
-    PTRVEC_addTail (self, self->sortBuf[i]);
-  }
+  /*--- Sort each piece ---*/
+  for (i = 0; i < nPieces; ++i)
+    {
+      jobArr[i].cmp = cmp;
+      jobArr[i].arr = arr;
+      jobArr[i].tmp = tmp;
+      jobArr[i].lo = (unsigned long long) n * i / nPieces;
+      jobArr[i].hi = (unsigned long long) n * (i + 1) / nPieces;
+    }
+  runJobs (jobArr, nPieces);
+
+  /*--- Merge pairs of pieces, back and forth, until there is one ---*/
+  void **src = arr, **dst = tmp;
+  unsigned int nRuns;
+  for (nRuns = nPieces; nRuns > 1; nRuns /= 2)
+    {
+      for (i = 0; i < nRuns / 2; ++i)
+        {
+          struct sort_job *job = jobArr + i;
+          memset (job, 0, sizeof (*job));
+          job->cmp = cmp;
+          job->src = src;
+          job->dst = dst;
+          job->lo = (unsigned long long) n * (2 * i) / nRuns;
+          job->mid = (unsigned long long) n * (2 * i + 1) / nRuns;
+          job->hi = (unsigned long long) n * (2 * i + 2) / nRuns;
+        }
+      runJobs (jobArr, nRuns / 2);
+
+      void **swap = src;
+      src = dst;
+      dst = swap;
+    }
+
+  if (src != arr)
+    memcpy (arr, src, sz);
 
+  if (self->ndxArr)
+    ndx_fill (self);
   return 0;
 }
 
@@ -138,11 +550,45 @@ PTRVEC_resize (PTRVEC * self, unsigned int maxItems)
 
   if (!maxItems)
     return 0;
-  if (maxItems < self->numItems)
+  if (!(maxItems = pow2 (maxItems)) || maxItems < self->numItems)
     return 1;
 
+  /* Items move, so the index is rebuilt to suit; get room for it first */
+  struct ptrvec_slot *ndxArr = NULL;
+  if (self->ndxArr)
+    {
+      if (maxItems * 2 < maxItems ||
+          !(ndxArr = malloc (maxItems * 2 * sizeof (*ndxArr))))
+        return 1;
+    }
+
+  /* Shrinking; copy the items to the start of a smaller array, since
+   * they may lie past its end.
+   */
+  if (maxItems < self->maxItems)
+    {
+      void **arr = malloc (maxItems * sizeof (void*));
+      unsigned int i;
+      if (!arr)
+        {
+          if (ndxArr) free (ndxArr);
+          return 1;
+        }
+      for (i = 0; i < self->numItems; ++i)
+        arr[i] = self->ptrArr[(self->head + i) & PTRVEC_mask (self)];
+      free (self->ptrArr);
+      self->ptrArr = arr;
+      self->head = 0;
+      self->tail = self->numItems ? self->numItems - 1 : 0;
+      self->maxItems = maxItems;
+      goto reindex;
+    }
+
   if (!(tmp = realloc (self->ptrArr, maxItems * sizeof (void*))))
-    return 1;
+    {
+      if (ndxArr) free (ndxArr);
+      return 1;
+    }
   self->ptrArr = tmp;
 
   if (self->head > self->tail)
@@ -156,6 +602,14 @@ PTRVEC_resize (PTRVEC * self, unsigned int maxItems)
 
   self->maxItems = maxItems;
 
+reindex:
+  if (ndxArr)
+    {
+      free (self->ndxArr);
+      self->ndxArr = ndxArr;
+      self->ndx_mask = maxItems * 2 - 1;
+      ndx_fill (self);
+    }
   return 0;
 }
 
@@ -167,9 +621,11 @@ PTRVEC_addHead (PTRVEC * self, void *ptr)
     return NULL;
 
   if (self->numItems)
-    self->head = (self->head + self->maxItems - 1) % self->maxItems;
+    self->head = (self->head - 1) & PTRVEC_mask (self);
 
   self->ptrArr[self->head] = ptr;
+  if (self->ndxArr)
+    ndx_insert (self, ptr, self->head);
   self->numItems++;
   return ptr;
 }
@@ -183,8 +639,10 @@ PTRVEC_remHead (PTRVEC * self)
     return NULL;
   self->numItems--;
   tmp = self->ptrArr[self->head];
+  if (self->ndxArr)
+    ndx_delete (self, tmp, self->head);
   if (self->numItems)
-    self->head = (self->head + 1) % self->maxItems;
+    self->head = (self->head + 1) & PTRVEC_mask (self);
 
   return tmp;
 }
@@ -196,9 +654,11 @@ PTRVEC_addTail (PTRVEC * self, void *ptr)
     return NULL;
 
   if (self->numItems)
-    self->tail = (self->tail + 1) % self->maxItems;
+    self->tail = (self->tail + 1) & PTRVEC_mask (self);
 
   self->ptrArr[self->tail] = ptr;
+  if (self->ndxArr)
+    ndx_insert (self, ptr, self->tail);
   self->numItems++;
   return ptr;
 }
@@ -212,46 +672,68 @@ PTRVEC_remTail (PTRVEC * self)
     return NULL;
   self->numItems--;
   tmp = self->ptrArr[self->tail];
+  if (self->ndxArr)
+    ndx_delete (self, tmp, self->tail);
 
   if (self->numItems)
-    self->tail = (self->tail + self->maxItems - 1) % self->maxItems;
+    self->tail = (self->tail - 1) & PTRVEC_mask (self);
   return tmp;
 }
 
 void *
 PTRVEC_remove (PTRVEC * self, void *item)
 {
-  unsigned int blockLen;
-  unsigned int ndx;
+  unsigned int ndx, s;
 
   if (!PTRVEC_find (self, &ndx, item))
     return NULL;
 
+  if (self->ndxArr)
+    ndx_delete (self, item, ndx);
+
   if (self->numItems == 1)
     {
       self->head = self->tail = 0;
     }
-  else if (ndx == self->head)
+  else if (((ndx - self->head) & PTRVEC_mask (self)) < self->numItems / 2)
     {
-      self->head = (self->head + 1) % self->maxItems;
+      /* Closer to the head; move those before it up */
+      for (s = ndx; s != self->head; s = (s - 1) & PTRVEC_mask (self))
+        move_item (self, (s - 1) & PTRVEC_mask (self), s);
+      self->head = (self->head + 1) & PTRVEC_mask (self);
     }
-  else if (ndx == self->tail)
+  else
     {
-      self->tail = (self->tail + self->maxItems - 1) % self->maxItems;
+      /* Closer to the tail; move those after it down */
+      for (s = ndx; s != self->tail; s = (s + 1) & PTRVEC_mask (self))
+        move_item (self, (s + 1) & PTRVEC_mask (self), s);
+      self->tail = (self->tail - 1) & PTRVEC_mask (self);
     }
-  else if (ndx < self->tail)	/* Non contiguous, top block */
+
+  self->numItems--;
+  return item;
+}
+
+void *
+PTRVEC_removeUnordered (PTRVEC * self, void *item)
+{
+  unsigned int ndx;
+
+  if (!PTRVEC_find (self, &ndx, item))
+    return NULL;
+
+  if (self->ndxArr)
+    ndx_delete (self, item, ndx);
+
+  if (self->numItems == 1)
     {
-      blockLen = self->tail - ndx;
-      memmove (self->ptrArr + ndx,
-	       self->ptrArr + ndx + 1, blockLen * sizeof (*self->ptrArr));
-      self->tail--;
+      self->head = self->tail = 0;
     }
-  else				/* Contiguous or non contiguous bottom block */
+  else
     {
-      blockLen = ndx - self->head;
-      memmove (self->ptrArr + self->head + 1,
-	       self->ptrArr + self->head, blockLen * sizeof (*self->ptrArr));
-      self->head++;
+      if (ndx != self->tail)
+        move_item (self, self->tail, ndx);
+      self->tail = (self->tail - 1) & PTRVEC_mask (self);
     }
 
   self->numItems--;
@@ -21,13 +21,30 @@
 #ifndef PTRVEC_H
 #define PTRVEC_H
 
+#include <stddef.h>
+
+/* PTRVEC_stableSort() may start threads, so link with -pthread. */
+
+/* maxItems is always a power of 2, so positions in the ring wrap with
+ * a mask rather than a division.
+ */
 typedef struct
 {
   void **ptrArr;
   unsigned int maxItems, numItems, head, tail;
 
   void **sortBuf;
-  unsigned sortBuf_sz;
+  size_t sortBuf_sz;
+
+  /* Optional hash index from each item to its slot in ptrArr, turned
+   * on by PTRVEC_index(). ndx_mask is one less than the table size.
+   */
+  struct ptrvec_slot
+  {
+    const void *item;
+    unsigned int slot;
+  } *ndxArr;
+  unsigned int ndx_mask;
 }
 PTRVEC;
 
@@ -52,7 +69,8 @@ PTRVEC *PTRVEC_constructor (PTRVEC * self, unsigned int initMaxItems);
 /***********************************************
  * Construct a PTRVEC.
  *
- * initMaxItems - a guess at how many items it will need to hold.
+ * initMaxItems - a guess at how many items it will need to hold,
+ *    rounded up to a power of 2.
  * returns - pointer to the object, or NULL for failure.
  */
 
@@ -102,28 +120,74 @@ int PTRVEC_resize (PTRVEC * self, unsigned int maxItems);
  * Resize the vector.  This is normally done automatically
  * for you.
  *
- * maxItems - the new number of items to use in the list.
+ * maxItems - the new number of items to use in the list, rounded up
+ *    to a power of 2.
  * returns - nonzero if there is not enough memory, or if maxItems < self->numItems.
  */
 
 int PTRVEC_sort (PTRVEC * self, int (*cmp) (const void *const*, const void *const*));
 /************************************************
  * Use qsort() to sort the items in the vector according to the cmp function.
+ * The ring is unwrapped and sorted in place, without copying.
+ *
+ * cmp - function pointer to use for comparison.
+ * returns - nonzero for failure
+ */
+
+int PTRVEC_stableSort (PTRVEC * self, int (*cmp) (const void *const*, const void *const*), unsigned int nThreads);
+/************************************************
+ * Merge sort the items in the vector according to the cmp function. Items
+ * which compare equal keep their order, so sorting by one key and then
+ * another leaves items grouped by the second, in order of the first. Big
+ * vectors, with at least 64k items for each thread, are split across as many
+ * as nThreads threads, sorted, and merged back together.
  *
  * cmp - function pointer to use for comparison.
+ * nThreads - most threads to use; 0 or 1 means just this one.
  * returns - nonzero for failure (not enough memory for temporary block)
  */
 
+void **PTRVEC_unwrap (PTRVEC * self);
+/************************************************
+ * Move the items in place so they start at the beginning of the ring,
+ * and are in one piece.
+ *
+ * returns - pointer to the first of numItems items.
+ */
+
+int PTRVEC_index (PTRVEC * self);
+/************************************************
+ * Keep a hash index of where each item is, so PTRVEC_find(),
+ * PTRVEC_remove() and PTRVEC_removeUnordered() needn't search. It is
+ * kept up to date by the functions here; after writing to ptrArr
+ * directly, call this again to rebuild it.
+ *
+ * returns - nonzero if there is not enough memory.
+ */
+
+void PTRVEC_clearIndex (PTRVEC * self);
+/************************************************
+ * Empty the index, for PTRVEC_reset().
+ */
+
 int PTRVEC_find (const PTRVEC * self, unsigned *ndxBuf, const void *item);
 /************************************************
- * Searches for an item.  If found, returns 0 and writes index number of
- * item into ndxBuf. if ndxBuf is not NULL.
+ * Searches for an item.  If found, writes its slot in ptrArr into
+ * ndxBuf, if ndxBuf is not NULL. With an index, this takes constant
+ * expected time, rather than a scan.
  * returns 1 if found, 0 if not found.
  */
 
 void *PTRVEC_remove (PTRVEC * self, void *item);
 /***************************************************
- * Remove an item from the PTRVEC.
+ * Remove an item from the PTRVEC, keeping the rest in order. Whichever
+ * side of it is shorter is moved up to close the gap.
+ */
+
+void *PTRVEC_removeUnordered (PTRVEC * self, void *item);
+/***************************************************
+ * Remove an item from the PTRVEC, moving the last item into its place.
+ * With an index, this takes constant expected time.
  */
 
 #ifdef DEBUG
@@ -135,7 +199,7 @@ PTRVEC_assert_integrity(PTRVEC *self);
 #endif
 
 #define PTRVEC_reset(self) \
-   (self)->numItems= (self)->head= (self)->tail= 0
+   ((self)->numItems= (self)->head= (self)->tail= 0, (self)->ndxArr?PTRVEC_clearIndex(self):(void)0)
 /************************************************
  * void PTRVEC_reset(PTRVEC *self);
  * Reset the 'list' to contain no items.
@@ -149,8 +213,16 @@ PTRVEC_assert_integrity(PTRVEC *self);
  * Return the number of items in the 'list'.
  */
 
+#define PTRVEC_mask(self) \
+   ((self)->maxItems-1)
+/*************************************************
+ * unsigned int PTRVEC_mask(PTRVEC *self);
+ *
+ * Mask to wrap a position in the ring.
+ */
+
 #define PTRVEC_ndxPtr(self, ndx) \
-   (ndx>=(self)->numItems?0:(self)->ptrArr[((self)->head+ndx)%(self)->maxItems])
+   (ndx>=(self)->numItems?0:(self)->ptrArr[((self)->head+ndx)&PTRVEC_mask(self)])
 /*************************************************
  * void *PTRVEC_ndxPtr(PTRVEC *self, unsigned int ndx);
  *
@@ -178,6 +250,16 @@ PTRVEC_assert_integrity(PTRVEC *self);
  * returns - pointer to the last item, or NULL if the vector is emtpy.
  */
 
+#define PTRVEC_contig(self) \
+   ((self)->head+(self)->numItems<=(self)->maxItems?(self)->ptrArr+(self)->head:0)
+/*******************************************************
+ * void **PTRVEC_contig(PTRVEC *self);
+ * If the items are in one piece, i.e. the ring hasn't
+ * wrapped, gets them as a plain array of numItems
+ * pointers, for loops which need no wrapping at all.
+ *
+ * returns - pointer to the first item, or NULL if the ring has wrapped.
+ */
 
 #ifdef __cplusplus
 
@@ -185,24 +267,24 @@ PTRVEC_assert_integrity(PTRVEC *self);
 #define PTRVEC_loopFwd(self, i, ptr) \
    for(i=0, ptr= (decltype(ptr))(self)->ptrArr[(self)->head];\
        i < (self)->numItems;\
-       ++i, ptr= (decltype(ptr))(self)->ptrArr[((self)->head+i)%(self)->maxItems])
+       ++i, ptr= (decltype(ptr))(self)->ptrArr[((self)->head+i)&PTRVEC_mask(self)])
 
 #define PTRVEC_loopBkwd(self, i, ptr) \
    for(i=0, ptr= (decltype(ptr))(self)->ptrArr[(self)->tail];\
        i < (self)->numItems;\
-       ++i, ptr= (decltype(ptr))(self)->ptrArr[((self)->tail+(self)->maxItems-i)%(self)->maxItems])
+       ++i, ptr= (decltype(ptr))(self)->ptrArr[((self)->tail-i)&PTRVEC_mask(self)])
 #else
 
 /* Macros for traversing vector in list like fashion */
 #define PTRVEC_loopFwd(self, i, ptr) \
    for(i=0, ptr= (typeof(ptr))(self)->ptrArr[(self)->head];\
        i < (self)->numItems;\
-       ++i, ptr= (typeof(ptr))(self)->ptrArr[((self)->head+i)%(self)->maxItems])
+       ++i, ptr= (typeof(ptr))(self)->ptrArr[((self)->head+i)&PTRVEC_mask(self)])
 
 #define PTRVEC_loopBkwd(self, i, ptr) \
    for(i=0, ptr= (typeof(ptr))(self)->ptrArr[(self)->tail];\
        i < (self)->numItems;\
-       ++i, ptr= (typeof(ptr))(self)->ptrArr[((self)->tail+(self)->maxItems-i)%(self)->maxItems])
+       ++i, ptr= (typeof(ptr))(self)->ptrArr[((self)->tail-i)&PTRVEC_mask(self)])
 
 #endif
 
@@ -57,8 +57,14 @@ STR_constructor(STR *self, size_t sz_hint)
 
   assert(sz_hint);
 
-  self->sz= sz_hint;
-  if(!(self->buf= malloc(self->sz))) goto abort;
+  self->arena= NULL;
+  if(sz_hint <= STR_SSO_SZ) {
+    self->buf= self->sso;
+    self->sz= STR_SSO_SZ;
+  } else {
+    self->sz= sz_hint;
+    if(!(self->buf= malloc(self->sz))) goto abort;
+  }
   STR_reset(self);
 
   rtn= self;
@@ -67,13 +73,48 @@ abort:
   return rtn;
 }
 
+STR*
+STR_arena_constructor(STR *self, size_t sz_hint, ARENA *arena)
+/**********************************************************************************
+ * Prepare a STR for use with initial size of sz_hint, getting bigger buffers
+ * from arena.
+ */
+{
+  STR *rtn= NULL;
+
+  assert(sz_hint);
+
+  self->arena= arena;
+  if(sz_hint <= STR_SSO_SZ) {
+    STR_recycle(self);
+  } else {
+    self->sz= sz_hint;
+    if(!(self->buf= ARENA_alloc(arena, self->sz))) goto abort;
+    STR_reset(self);
+  }
+
+  rtn= self;
+
+abort:
+  return rtn;
+}
+
+static inline int
+is_heap(const STR *self)
+/**********************************************************************************
+ * Does the buffer belong to the heap, rather than to the STR or an arena?
+ */
+{
+  return self->buf && self->buf != self->sso && !self->arena;
+}
+
 void*
 STR_destructor(STR *self)
 /**********************************************************************************
  * Free resources associated with STR.
  */
 {
-  if(self->buf) free(self->buf);
+  if(is_heap(self)) free(self->buf);
   return self;
 }
 
@@ -91,8 +132,15 @@ growbuf(STR *self)
   for(i= 20; i > 10; i--) {
     char *p;
     size_t new_sz= self->sz * i / 10;
-    /* Try to reallocate the memory */
-    if(!(p= realloc(self->buf, new_sz))) continue;
+
+    if(is_heap(self)) {
+      /* Try to reallocate the memory */
+      if(!(p= realloc(self->buf, new_sz))) continue;
+    } else {
+      /* Moving out of sso, or to a bigger piece of the arena */
+      if(!(p= self->arena ? ARENA_alloc(self->arena, new_sz) : malloc(new_sz))) continue;
+      memcpy(p, self->buf, self->len + 1);
+    }
     /* Try vsnprintf() again */
     self->buf= p;
     self->sz = new_sz;
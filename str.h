@@ -25,20 +25,38 @@
 #include <stdarg.h>
 #include <sys/types.h>
 
+#include "arena.h"
+
 /* STR is a dynamically sized null terminated string buffer which is always
  * appended until STR_reset() is called. It is particularly useful for
  * things like creating complex SQL queries.
+ *
+ * Short strings are kept in a buffer inside the STR itself, so they never
+ * touch the heap. Longer ones go on the heap, or, for a STR constructed
+ * with STR_arena_constructor(), in an ARENA.
  */
 
+/* Size of the buffer inside each STR */
+#define STR_SSO_SZ 64
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Never copy or move a STR by value; buf may point into the STR itself,
+ * and a heap buffer would be shared, and freed twice.
+ */
 typedef struct _cb {
   size_t sz,
          len;
 
+  /* sso, heap memory, or memory from arena */
   char *buf;
+
+  /* Where bigger buffers come from, or NULL for the heap */
+  ARENA *arena;
+
+  char sso[STR_SSO_SZ];
 } STR;
 
 #define STR_str(self) \
@@ -71,7 +89,24 @@ STR_sinit(STR *self, size_t sz_hint);
 STR*
 STR_constructor(STR *self, size_t sz_hint);
 /**********************************************************************************
- * Prepare a STR for use with initial size of sz_hint.
+ * Prepare a STR for use with initial size of sz_hint. Nothing is allocated
+ * if sz_hint is no more than STR_SSO_SZ.
+ */
+
+STR*
+STR_arena_constructor(STR *self, size_t sz_hint, ARENA *arena);
+/**********************************************************************************
+ * Prepare a STR for use with initial size of sz_hint, getting any buffers
+ * too big for the STR itself from arena. A buffer from the arena is no good
+ * once the arena is reset, so call STR_recycle() whenever it is.
+ */
+
+#define STR_recycle(self) \
+  ((self)->buf= (self)->sso, (self)->sz= STR_SSO_SZ, STR_reset(self))
+/**********************************************************************************
+ * void STR_recycle(STR *self);
+ * For a STR constructed with STR_arena_constructor(), go back to the buffer
+ * in the STR, leaving any bigger one to the arena. Resets the STR too.
  */
 
 
@@ -80,7 +115,8 @@ STR_constructor(STR *self, size_t sz_hint);
 void*
 STR_destructor(STR *self);
 /**********************************************************************************
- * Free resources associated with STR.
+ * Free resources associated with STR. Memory from an arena is left for the
+ * arena to free.
  */
 
 int
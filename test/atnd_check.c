@@ -0,0 +1,251 @@
+/************************************************************
+ * Check ATND records: what ATND_arena_create() keeps of an
+ * ATTENDEE value, including names and addresses longer than
+ * an arena chunk, and what it refuses.
+ *
+ * Then check ATND_sort() against a plain stable sort by
+ * strcasecmp(), on lists with repeated names and addresses
+ * in mixed case, names either side of the 16 byte key, and
+ * lengths either side of each 16 item run it sorts first.
+ */
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atnd.h"
+
+static int N_fail;
+
+static ATND*
+make(ARENA *arena, const char *name, const char *role, const char *email)
+/***********************************************
+ * Build an ATTENDEE value, and an ATND from it.
+ */
+{
+   char *src;
+   if(-1 == asprintf(&src, ";ROLE=%s;PARTSTAT=NEEDS-ACTION;CN=\"%s\":mailto:%s", role, name, email))
+      abort();
+
+   ATND *rtn= ATND_arena_create(arena, src);
+   free(src);
+   return rtn;
+}
+
+static void
+checkRecord(ARENA *arena, const char *name, const char *role, const char *email)
+/***********************************************
+ * Build an ATND, and check it holds what it should.
+ */
+{
+   ATND *atnd= make(arena, name, role, email);
+   if(!atnd) {
+      fprintf(stderr, "FAIL: no ATND for \"%.40s\" <%.40s>\n", name, email);
+      ++N_fail;
+      return;
+   }
+
+   if(strcmp(ATND_name(atnd), name) || strcmp(ATND_email(atnd), email)) {
+      fprintf(stderr, "FAIL: \"%.40s\" <%.40s> came back as \"%.40s\" <%.40s>\n",
+            name, email, ATND_name(atnd), ATND_email(atnd));
+      ++N_fail;
+   }
+
+   int is_reqd= !strcasecmp(role, "REQ-PARTICIPANT");
+   if(!(atnd->flags & ATND_REQD_FLG) != !is_reqd) {
+      fprintf(stderr, "FAIL: \"%.40s\" with ROLE=%s\n", name, role);
+      ++N_fail;
+   }
+
+   /* The key is the first 16 bytes of the name, case folded, padded with nulls */
+   uint64_t keyArr[2]= {0, 0};
+   size_t i,
+          len= strlen(name);
+   for(i= 0; i < 16; ++i)
+      keyArr[i / 8]= keyArr[i / 8] << 8 | (i < len ? (unsigned char)tolower((unsigned char)name[i]) : 0);
+   if(keyArr[0] != atnd->keyArr[0] || keyArr[1] != atnd->keyArr[1]) {
+      fprintf(stderr, "FAIL: key for \"%.40s\"\n", name);
+      ++N_fail;
+   }
+
+   /* The keys are read as uint64_t */
+   if((uintptr_t)atnd % ARENA_ALIGN) {
+      fprintf(stderr, "FAIL: ATND for \"%.40s\" is not aligned\n", name);
+      ++N_fail;
+   }
+}
+
+/* Names alike in their first 16 bytes, or all of them */
+static const char *const NameArr[]= {
+   "Al",
+   "al",
+   "Alexandra Fitzg",         /* 15 */
+   "alexandra fitzge",        /* 16 */
+   "ALEXANDRA FITZGE",
+   "Alexandra Fitzger",       /* 17 */
+   "Alexandra Fitzgerald",
+   "Alexandra FitzGERALD",
+   "Alexandra Fitzgerald Jr",
+   "Alexandra Fitzgerald, Jr",
+   "Bob",
+   "bob ",
+   "Zed",
+};
+#define N_NAMES (sizeof(NameArr) / sizeof(NameArr[0]))
+
+struct ref {
+   ATND *atnd;
+   unsigned seq;
+};
+
+static int
+ref_cmp(const void *p1, const void *p2)
+/***********************************************
+ * By name ignoring case, then by where it was.
+ */
+{
+   const struct ref *r1= p1,
+                    *r2= p2;
+   int rtn= strcasecmp(ATND_name(r1->atnd), ATND_name(r2->atnd));
+   return rtn ? rtn : (r1->seq > r2->seq) - (r1->seq < r2->seq);
+}
+
+static void
+checkSort(ARENA *arena, unsigned n)
+/***********************************************
+ * Sort n attendees, and compare with qsort().
+ */
+{
+   static const char *const emailArr[]= {"a@x", "A@X", "b@x"};
+   struct ref *refArr= malloc((n + 1) * sizeof(*refArr));
+   PTRVEC vec;
+   unsigned i,
+            nNames= 1 + rand() % N_NAMES,
+            nPre= rand() % (n + 1);
+   char src[128];
+
+   PTRVEC_constructor(&vec, 1 + rand() % 64);
+
+   /* Move head along, so the items may wrap around the ring */
+   for(i= 0; i < nPre; ++i)
+      PTRVEC_addTail(&vec, refArr);
+   for(i= 0; i < nPre; ++i)
+      PTRVEC_remHead(&vec);
+
+   for(i= 0; i < n; ++i) {
+      snprintf(src, sizeof(src), ";CN=\"%s\":mailto:%s",
+            NameArr[rand() % nNames], emailArr[rand() % 3]);
+      refArr[i].atnd= ATND_arena_create(arena, src);
+      refArr[i].seq= i;
+      if(!refArr[i].atnd)
+         abort();
+      PTRVEC_addTail(&vec, refArr[i].atnd);
+   }
+
+   qsort(refArr, n, sizeof(*refArr), ref_cmp);
+
+   if(ATND_sort(&vec, arena) || PTRVEC_numItems(&vec) != n) {
+      fprintf(stderr, "FAIL: ATND_sort() of %u items\n", n);
+      ++N_fail;
+      goto abort;
+   }
+
+   /* The same records, in the same order, equal names included */
+   for(i= 0; i < n; ++i) {
+      ATND *atnd= PTRVEC_ndxPtr(&vec, i);
+      if(atnd != refArr[i].atnd) {
+         fprintf(stderr, "FAIL: %u items: [%u] is \"%s\" <%s>, not \"%s\" <%s>\n",
+               n, i, ATND_name(atnd), ATND_email(atnd),
+               ATND_name(refArr[i].atnd), ATND_email(refArr[i].atnd));
+         ++N_fail;
+         goto abort;
+      }
+   }
+
+abort:
+   PTRVEC_destructor(&vec);
+   free(refArr);
+   ARENA_reset(arena);
+}
+
+int
+main(void)
+{
+   ARENA arena;
+   ARENA_constructor(&arena, 16384);
+
+   static const char *const roleArr[]= {"REQ-PARTICIPANT", "req-participant", "OPT-PARTICIPANT", "CHAIR"};
+   char name[40000],
+        email[40000];
+   unsigned i, j;
+
+   srand(18);
+
+   /* Lengths on both sides of the 16 byte key, and past a whole chunk */
+   static const unsigned lenArr[]= {1, 2, 7, 15, 16, 17, 31, 100, 16383, 20000, 39999};
+
+   for(i= 0; i < 2000; ++i) {
+
+      unsigned name_len= lenArr[rand() % 11],
+               email_len= lenArr[rand() % 11];
+
+      for(j= 0; j < name_len; ++j)
+         name[j]= "aBcDeF gHiJ,;:.-'"[rand() % 17];
+      name[0]= 'N';
+      name[name_len]= '\0';
+
+      for(j= 0; j < email_len; ++j)
+         email[j]= "xyz.@-_09"[rand() % 9];
+      email[email_len]= '\0';
+
+      checkRecord(&arena, name, roleArr[rand() % 4], email);
+
+      /* Now and then start afresh, as each event does */
+      if(rand() % 50 == 0)
+         ARENA_reset(&arena);
+   }
+
+   /* The address ends at white space, and mailto: may be in any case */
+   ATND *atnd= ATND_arena_create(&arena, ";CN=Jo:MAILTO:jo@x.com trailing");
+   if(!atnd || strcmp(ATND_email(atnd), "jo@x.com")) {
+      fprintf(stderr, "FAIL: address with trailing text\n");
+      ++N_fail;
+   }
+
+   /* What can't be an attendee */
+   static const char *const badArr[]= {
+      ";ROLE=CHAIR:mailto:a@x",   /* No CN */
+      ";CN=:mailto:a@x",          /* Empty CN */
+      ";CN=A:http://x",           /* Not mailto: */
+      ";CN=A:mailto:",            /* No address */
+      ";CN=A:mailto:  ",
+      ";CN=\"A:mailto:a@x",       /* Unclosed quote */
+   };
+   fprintf(stderr, "(Expect %zu errors here)\n", sizeof(badArr) / sizeof(badArr[0]));
+   for(i= 0; i < sizeof(badArr) / sizeof(badArr[0]); ++i) {
+      if(ATND_arena_create(&arena, badArr[i])) {
+         fprintf(stderr, "FAIL: \"%s\" made an ATND\n", badArr[i]);
+         ++N_fail;
+      }
+   }
+
+   /* Sizes either side of each run, and of merging two, three and four */
+   static const unsigned nArr[]= {0, 1, 2, 15, 16, 17, 31, 32, 33, 47, 48, 49, 63, 64, 65};
+   unsigned nSorts= 0;
+   for(i= 0; i < 200; ++i) {
+      for(j= 0; j < sizeof(nArr) / sizeof(nArr[0]); ++j, ++nSorts)
+         checkSort(&arena, nArr[j]);
+      checkSort(&arena, rand() % 500);
+      ++nSorts;
+   }
+
+   ARENA_destructor(&arena);
+
+   if(N_fail)
+      return 1;
+
+   printf("ATND: 2000 records, up to %u byte names and addresses, %zu bad values, and %u sorts as expected\n",
+         lenArr[10], sizeof(badArr) / sizeof(badArr[0]), nSorts);
+   return 0;
+}
@@ -0,0 +1,237 @@
+/************************************************************
+ * Check ical_params() and ical_slice_is().
+ *
+ * A table of hand written cases covers quoting, case, lists,
+ * empty values and malformed input. Then random parameter
+ * lists are built from known parts, with values quoted when
+ * they hold ';', ':' or ',', names in any case, unknown
+ * parameters mixed in, and each known one maybe given twice,
+ * in which case the last one counts.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+static const char *const NameArr[]= {
+   "CN", "CUTYPE", "PARTSTAT", "ROLE", "RSVP", "SENT-BY", "TZID",
+};
+#define N_NAMES (sizeof(NameArr) / sizeof(NameArr[0]))
+
+static const struct ical_slice*
+slice(const struct ical_params *prm, unsigned ndx)
+/***********************************************
+ * Known parameter ndx of NameArr[] in prm.
+ */
+{
+   const struct ical_slice *arr[]= {
+      &prm->cn, &prm->cutype, &prm->partstat, &prm->role, &prm->rsvp, &prm->sent_by, &prm->tzid,
+   };
+   return arr[ndx];
+}
+
+static int N_fail;
+
+static void
+expectSlice(const char *src, const char *what, const struct ical_slice *got, const char *want)
+/***********************************************
+ * Complain unless got holds want, or is absent
+ * when want is NULL.
+ */
+{
+   if(!want ? !got->str : got->str && got->len == strlen(want) && !memcmp(got->str, want, got->len))
+      return;
+
+   fprintf(stderr, "FAIL: \"%s\": %s is \"%.*s\", not \"%s\"\n",
+         src, what, got->str ? (int)got->len : 6, got->str ? got->str : "(none)", want ? want : "(none)");
+   ++N_fail;
+}
+
+static const struct {
+   const char *src,
+              *value,  /* What should follow the ':', or NULL for failure */
+              *cn,
+              *role,
+              *tzid;
+} CaseArr[]= {
+   {";CN=Jane Doe:mailto:jane@x", "mailto:jane@x", "Jane Doe", NULL, NULL},
+   {"CN=Jane Doe:mailto:jane@x", "mailto:jane@x", "Jane Doe", NULL, NULL},
+   {";cn=\"Doe; Jane: Esq, PhD\";Role=REQ-PARTICIPANT:mailto:j@x", "mailto:j@x", "Doe; Jane: Esq, PhD", "REQ-PARTICIPANT", NULL},
+   {";TZID=\"(UTC-05:00) Eastern Time (US & Canada)\":20240101T090000", "20240101T090000", NULL, NULL, "(UTC-05:00) Eastern Time (US & Canada)"},
+   {";TZID=Eastern Standard Time:20240101T090000", "20240101T090000", NULL, NULL, "Eastern Standard Time"},
+   {";X-THING=\"a:b\";CN=A:v", "v", "A", NULL, NULL},
+   {";DELEGATED-TO=\"mailto:a@x\",\"mailto:b@x\";CN=B:v", "v", "B", NULL, NULL},
+   {";CN=\"a\",\"b\":v", "v", "\"a\",\"b\"", NULL, NULL},
+   {";CN=:v", "v", "", NULL, NULL},
+   {";CN=\"\":v", "v", "", NULL, NULL},
+   {";CN=First;CN=Second:v", "v", "Second", NULL, NULL},
+   {";CNX=No;XCN=No:v", "v", NULL, NULL, NULL},
+   {";RSVP:v", "v", NULL, NULL, NULL},
+   {":v", "v", NULL, NULL, NULL},
+   {";CN=\"unclosed:v", NULL, NULL, NULL, NULL},
+   {";CN=no colon", NULL, NULL, NULL, NULL},
+   {";CN=a\"b\":v", NULL, NULL, NULL, NULL},
+   {"", NULL, NULL, NULL, NULL},
+};
+
+static void
+checkTable(void)
+/***********************************************
+ * Run the hand written cases.
+ */
+{
+   unsigned i;
+   for(i= 0; i < sizeof(CaseArr) / sizeof(CaseArr[0]); ++i) {
+
+      struct ical_params prm;
+      const char *src= CaseArr[i].src,
+                 *value= ical_params(src, &prm);
+
+      if(!CaseArr[i].value != !value || (value && strcmp(value, CaseArr[i].value))) {
+         fprintf(stderr, "FAIL: \"%s\": value is \"%s\"\n", src, value ? value : "(NULL)");
+         ++N_fail;
+         continue;
+      }
+
+      if(!value)
+         continue;
+
+      expectSlice(src, "CN", &prm.cn, CaseArr[i].cn);
+      expectSlice(src, "ROLE", &prm.role, CaseArr[i].role);
+      expectSlice(src, "TZID", &prm.tzid, CaseArr[i].tzid);
+   }
+}
+
+static void
+checkSliceIs(void)
+/***********************************************
+ * ical_slice_is() ignores case, and needs the
+ * whole of both.
+ */
+{
+   static const struct {
+      const char *str;
+      size_t len;
+      const char *cmp;
+      int want;
+   } arr[]= {
+      {"REQ-PARTICIPANT", 15, "REQ-PARTICIPANT", 1},
+      {"req-Participant", 15, "REQ-PARTICIPANT", 1},
+      {"REQ-PARTICIPANTS", 16, "REQ-PARTICIPANT", 0},
+      {"REQ-PARTICIPANT", 14, "REQ-PARTICIPANT", 0},
+      {"REQ-PARTICIPANT;X", 15, "REQ-PARTICIPANT", 1},
+      {"", 0, "", 1},
+      {"", 0, "X", 0},
+      {NULL, 0, "", 0},
+   };
+   unsigned i;
+   for(i= 0; i < sizeof(arr) / sizeof(arr[0]); ++i) {
+      struct ical_slice s= {arr[i].str, arr[i].len};
+      if(!ical_slice_is(&s, arr[i].cmp) != !arr[i].want) {
+         fprintf(stderr, "FAIL: ical_slice_is(\"%.*s\", \"%s\")\n",
+               (int)arr[i].len, arr[i].str ? arr[i].str : "", arr[i].cmp);
+         ++N_fail;
+      }
+   }
+}
+
+static void
+randomValue(char *buf)
+/***********************************************
+ * A parameter value, with or without characters
+ * which need quotes.
+ */
+{
+   static const char chars[]= "abcXYZ019 -_.@()&;:,";
+   unsigned i,
+            len= rand() % 12;
+   for(i= 0; i < len; ++i)
+      buf[i]= chars[rand() % (sizeof(chars) - 1)];
+   buf[len]= '\0';
+}
+
+static void
+randomCase(char *dst, const char *src)
+/***********************************************
+ * src, with letters in any case.
+ */
+{
+   for(; *src; ++src, ++dst)
+      *dst= rand() & 1 ? *src : (char)(*src ^ ('A' <= *src && *src <= 'Z' ? 0x20 : 0));
+   *dst= '\0';
+}
+
+static void
+checkRandom(unsigned nTries)
+/***********************************************
+ * Build random parameter lists, and check every
+ * known value is found.
+ */
+{
+   char src[2048],
+        wantArr[N_NAMES][32],
+        name[32],
+        val[32];
+   int hasArr[N_NAMES];
+   unsigned i, j;
+
+   for(i= 0; i < nTries; ++i) {
+
+      size_t len= 0;
+      memset(hasArr, 0, sizeof(hasArr));
+
+      unsigned nParams= rand() % 10;
+      for(j= 0; j < nParams; ++j) {
+
+         randomValue(val);
+         int is_quoted= strpbrk(val, ";:,") || rand() % 4 == 0;
+
+         if(rand() % 4 == 0) {
+            /* Unknown, perhaps named like a known one */
+            static const char *const otherArr[]= {"X-CN", "CNAME", "DIR", "LANGUAGE", "TZ", "ROLES"};
+            randomCase(name, otherArr[rand() % 6]);
+         } else {
+            unsigned ndx= rand() % N_NAMES;
+            randomCase(name, NameArr[ndx]);
+            strcpy(wantArr[ndx], val);
+            hasArr[ndx]= 1;
+         }
+
+         len += sprintf(src + len, ";%s=%s%s%s", name, is_quoted ? "\"" : "", val, is_quoted ? "\"" : "");
+      }
+      strcpy(src + len, ":the:value");
+
+      struct ical_params prm;
+      const char *value= ical_params(src, &prm);
+      if(!value || strcmp(value, "the:value")) {
+         fprintf(stderr, "FAIL: \"%s\": value is \"%s\"\n", src, value ? value : "(NULL)");
+         ++N_fail;
+         return;
+      }
+
+      for(j= 0; j < N_NAMES; ++j)
+         expectSlice(src, NameArr[j], slice(&prm, j), hasArr[j] ? wantArr[j] : NULL);
+
+      if(N_fail)
+         return;
+   }
+}
+
+int
+main(void)
+{
+   srand(19);
+
+   checkTable();
+   checkSliceIs();
+   checkRandom(500000);
+
+   if(N_fail)
+      return 1;
+
+   printf("ical_params: %zu cases and 500000 random parameter lists as expected\n",
+         sizeof(CaseArr) / sizeof(CaseArr[0]));
+   return 0;
+}
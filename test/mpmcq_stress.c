@@ -0,0 +1,149 @@
+/************************************************************
+ * Hammer an MPMCQ with several producers and consumers at
+ * once, through a queue much smaller than the traffic, and
+ * check every item comes out exactly once.
+ *
+ * Producers alternate MPMCQ_push() and MPMCQ_tryPush(), and
+ * consumers MPMCQ_pop() and MPMCQ_tryPop(), so both paths
+ * are exercised while the queue is full and while it is empty.
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpmcq.h"
+
+#define N_PRODUCERS 4
+#define N_CONSUMERS 4
+#define N_PER_PRODUCER 200000
+#define QUEUE_SZ 8
+
+/* Items are 1 + producer * N_PER_PRODUCER + i, never NULL */
+#define N_ITEMS (N_PRODUCERS * N_PER_PRODUCER)
+
+static MPMCQ *Q;
+
+/* How many times each item was seen */
+static unsigned char SeenArr[N_ITEMS + 1];
+
+/* Pushed by main() once per consumer, to stop it */
+static char Stop;
+
+struct consumer {
+   pthread_t tid;
+   unsigned ndx;
+   unsigned long n;
+   uint64_t sum;
+};
+
+static void*
+producer_main(void *arg)
+{
+   uintptr_t base= 1 + (uintptr_t)arg * N_PER_PRODUCER,
+             i;
+
+   for(i= 0; i < N_PER_PRODUCER; ++i) {
+      void *item= (void*)(base + i);
+      if(i & 1)
+         MPMCQ_push(Q, item);
+      else
+         while(MPMCQ_tryPush(Q, item))
+            ;
+   }
+   return NULL;
+}
+
+static void*
+consumer_main(void *arg)
+{
+   struct consumer *self= arg;
+
+   for(;;) {
+      void *item= self->ndx & 1 ? MPMCQ_pop(Q) : MPMCQ_tryPop(Q);
+      if(!item)
+         continue;
+      if(&Stop == item)
+         break;
+
+      uintptr_t v= (uintptr_t)item;
+      if(v > N_ITEMS) {
+         fprintf(stderr, "FAIL: bogus item %lu\n", (unsigned long)v);
+         exit(1);
+      }
+      ++SeenArr[v];
+      ++self->n;
+      self->sum += v;
+   }
+   return NULL;
+}
+
+int
+main(void)
+{
+   pthread_t prodArr[N_PRODUCERS];
+   struct consumer consArr[N_CONSUMERS];
+   uintptr_t i;
+
+   if(!MPMCQ_create(Q, QUEUE_SZ))
+      return 1;
+
+   /* Empty queue */
+   if(MPMCQ_tryPop(Q)) {
+      fprintf(stderr, "FAIL: popped from an empty queue\n");
+      return 1;
+   }
+
+   memset(consArr, 0, sizeof(consArr));
+   for(i= 0; i < N_CONSUMERS; ++i) {
+      consArr[i].ndx= i;
+      pthread_create(&consArr[i].tid, NULL, consumer_main, consArr + i);
+   }
+   for(i= 0; i < N_PRODUCERS; ++i)
+      pthread_create(prodArr + i, NULL, producer_main, (void*)i);
+
+   for(i= 0; i < N_PRODUCERS; ++i)
+      pthread_join(prodArr[i], NULL);
+   for(i= 0; i < N_CONSUMERS; ++i)
+      MPMCQ_push(Q, &Stop);
+   for(i= 0; i < N_CONSUMERS; ++i)
+      pthread_join(consArr[i].tid, NULL);
+
+   /*--- Every item exactly once ---*/
+   unsigned long n= 0;
+   uint64_t sum= 0;
+   for(i= 0; i < N_CONSUMERS; ++i) {
+      n += consArr[i].n;
+      sum += consArr[i].sum;
+   }
+   for(i= 1; i <= N_ITEMS; ++i) {
+      if(1 != SeenArr[i]) {
+         fprintf(stderr, "FAIL: item %lu seen %u times\n", (unsigned long)i, SeenArr[i]);
+         return 1;
+      }
+   }
+   if(n != N_ITEMS || sum != (uint64_t)N_ITEMS * (N_ITEMS + 1) / 2) {
+      fprintf(stderr, "FAIL: %lu items, checksum %llu\n", n, (unsigned long long)sum);
+      return 1;
+   }
+
+   /* Full queue */
+   for(i= 0; i < Q->maxItems; ++i) {
+      if(MPMCQ_tryPush(Q, &Stop)) {
+         fprintf(stderr, "FAIL: full after %lu of %u\n", (unsigned long)i, Q->maxItems);
+         return 1;
+      }
+   }
+   if(!MPMCQ_tryPush(Q, &Stop)) {
+      fprintf(stderr, "FAIL: pushed onto a full queue\n");
+      return 1;
+   }
+
+   printf("mpmcq: %d producers, %d consumers, %lu items through %u cells, each exactly once\n",
+         N_PRODUCERS, N_CONSUMERS, n, Q->maxItems);
+
+   MPMCQ_destroy(Q);
+   return 0;
+}
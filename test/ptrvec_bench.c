@@ -0,0 +1,56 @@
+/************************************************************
+ * Time removing 2000 random items from a PTRVEC of 200k
+ * with PTRVEC_removeUnordered(), by scanning and with the
+ * hash index.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ptrvec.h"
+
+#define N_ITEMS 200000
+#define N_REMOVE 2000
+
+static double
+now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double
+timeRemovals(int is_indexed)
+{
+   static char itemArr[N_ITEMS];
+   PTRVEC vec;
+   unsigned i;
+
+   PTRVEC_constructor(&vec, 16);
+   if(is_indexed)
+      PTRVEC_index(&vec);
+   for(i= 0; i < N_ITEMS; ++i)
+      PTRVEC_addTail(&vec, itemArr + i);
+
+   srand(23);
+   double t0= now();
+   for(i= 0; i < N_REMOVE; ++i)
+      PTRVEC_removeUnordered(&vec, itemArr + rand() % N_ITEMS);
+   double t1= now();
+
+   PTRVEC_destructor(&vec);
+   return t1 - t0;
+}
+
+int
+main(void)
+{
+   double scan= timeRemovals(0),
+          hash= timeRemovals(1);
+
+   printf("%d removals from %d items: scanning %.2f ms, indexed %.3f ms (%.0fx)\n",
+         N_REMOVE, N_ITEMS, scan * 1e3, hash * 1e3, scan / hash);
+   return 0;
+}
@@ -0,0 +1,208 @@
+/************************************************************
+ * Fuzz PTRVEC against a plain array doing the same things:
+ * adding and removing at both ends, removing from the
+ * middle, finding, resizing, unwrapping, sorting, and
+ * resetting, with rings of all sizes which wrap all the time.
+ * After every step the two must hold the same items in the
+ * same order, and maxItems must be a power of 2. Half the
+ * runs turn on the hash index part way through, which must
+ * then have exactly one right entry for each item.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ptrvec.h"
+
+#define MAX_ITEMS 100000
+
+/* The model */
+static void *ModelArr[MAX_ITEMS];
+static unsigned N_model;
+
+static int
+model_find(const void *item)
+{
+   unsigned i;
+   for(i= 0; i < N_model; ++i)
+      if(ModelArr[i] == item)
+         return i;
+   return -1;
+}
+
+static void
+model_remove(unsigned ndx)
+{
+   memmove(ModelArr + ndx, ModelArr + ndx + 1, (N_model - ndx - 1) * sizeof(*ModelArr));
+   --N_model;
+}
+
+static int
+ptr_cmp(const void *const* pp1, const void *const* pp2)
+{
+   return (*pp1 > *pp2) - (*pp1 < *pp2);
+}
+
+static int
+qsort_cmp(const void *p1, const void *p2)
+{
+   return ptr_cmp(p1, p2);
+}
+
+static int
+same(const PTRVEC *vec)
+/***********************************************
+ * Does vec hold what the model does?
+ */
+{
+   unsigned i;
+
+   if(PTRVEC_numItems(vec) != N_model || (vec->maxItems & (vec->maxItems - 1)))
+      return 0;
+
+   for(i= 0; i < N_model; ++i)
+      if(PTRVEC_ndxPtr(vec, i) != ModelArr[i])
+         return 0;
+
+   if(vec->ndxArr) {
+      unsigned n= 0;
+      for(i= 0; i <= vec->ndx_mask; ++i) {
+         const struct ptrvec_slot *e= vec->ndxArr + i;
+         if(~0u == e->slot)
+            continue;
+         ++n;
+         if(((e->slot - vec->head) & (vec->maxItems - 1)) >= N_model || vec->ptrArr[e->slot] != e->item)
+            return 0;
+      }
+      if(n != N_model)
+         return 0;
+   }
+
+   return 1;
+}
+
+static int
+step(PTRVEC *vec, char *pool, unsigned pool_sz)
+/***********************************************
+ * Do something random to both.
+ */
+{
+   void *item= pool + rand() % pool_sz;
+   unsigned ndx;
+   int i;
+
+   switch(rand() % 13) {
+
+      case 0:
+      case 1:
+         if(!PTRVEC_addTail(vec, item)) return -1;
+         ModelArr[N_model++]= item;
+         break;
+
+      case 2:
+         if(!PTRVEC_addHead(vec, item)) return -1;
+         memmove(ModelArr + 1, ModelArr, N_model * sizeof(*ModelArr));
+         ModelArr[0]= item;
+         ++N_model;
+         break;
+
+      case 3:
+         if(PTRVEC_remHead(vec) != (N_model ? ModelArr[0] : NULL)) return -1;
+         if(N_model) model_remove(0);
+         break;
+
+      case 4:
+         if(PTRVEC_remTail(vec) != (N_model ? ModelArr[N_model - 1] : NULL)) return -1;
+         if(N_model) --N_model;
+         break;
+
+      case 5:
+      case 6:
+         i= model_find(item);
+         if((i < 0) != !PTRVEC_remove(vec, item)) return -1;
+         if(i >= 0) model_remove(i);
+         break;
+
+      case 7:
+         /* ndxBuf gets the slot in ptrArr */
+         i= model_find(item);
+         if(PTRVEC_find(vec, &ndx, item) != (i >= 0)) return -1;
+         if(i >= 0 && ((ndx - vec->head) & (vec->maxItems - 1)) != (unsigned)i) return -1;
+         break;
+
+      case 8:
+         if(!(rand() % 8)) {
+            unsigned want= N_model + rand() % 20;
+            if(PTRVEC_resize(vec, want) && want) return -1;
+         }
+         break;
+
+      case 9:
+         if(!(rand() % 8)) {
+            void **arr= PTRVEC_unwrap(vec);
+            if(vec->head || (N_model && arr[N_model - 1] != ModelArr[N_model - 1])) return -1;
+         }
+         break;
+
+      case 10:
+         if(!(rand() % 8)) {
+            PTRVEC_sort(vec, ptr_cmp);
+            qsort(ModelArr, N_model, sizeof(*ModelArr), qsort_cmp);
+         }
+         break;
+
+      case 11:
+         if(!(rand() % 40)) {
+            PTRVEC_reset(vec);
+            N_model= 0;
+         }
+         break;
+
+      case 12:
+         /* The last item fills the hole */
+         i= model_find(item);
+         if((i < 0) != !PTRVEC_removeUnordered(vec, item)) return -1;
+         if(i >= 0) ModelArr[i]= ModelArr[--N_model];
+         break;
+   }
+
+   return 0;
+}
+
+int
+main(void)
+{
+   static char pool[300];
+   unsigned t, s;
+
+   srand(21);
+
+   for(t= 0; t < 300; ++t) {
+
+      PTRVEC vec;
+      N_model= 0;
+
+      /* Odd sizes get rounded up */
+      if(!PTRVEC_constructor(&vec, 1 + rand() % 9))
+         return 1;
+
+      /* Few distinct items, so there are duplicates, or many */
+      unsigned pool_sz= t & 1 ? sizeof(pool) : 20,
+               index_at= t & 2 ? rand() % 100 : ~0u;
+
+      for(s= 0; s < 5000; ++s) {
+         if(s == index_at && PTRVEC_index(&vec))
+            return 1;
+         if(step(&vec, pool, pool_sz) || !same(&vec)) {
+            fprintf(stderr, "FAIL: run %u, step %u\n", t, s);
+            return 1;
+         }
+      }
+
+      PTRVEC_destructor(&vec);
+   }
+
+   printf("ptrvec: 300 runs of 5000 steps match the model\n");
+   return 0;
+}
@@ -0,0 +1,97 @@
+/************************************************************
+ * Check PTRVEC_sort() and PTRVEC_stableSort() on rings which
+ * have and haven't wrapped, with many equal keys, on one
+ * thread and on several.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ptrvec.h"
+
+struct item {
+   int key;
+   unsigned seq;
+};
+
+static int
+item_cmp(const void *const* pp1, const void *const* pp2)
+{
+   const struct item *i1= *pp1,
+                     *i2= *pp2;
+   return (i1->key > i2->key) - (i1->key < i2->key);
+}
+
+static int
+check(unsigned n, unsigned nThreads, int is_stable)
+/***********************************************
+ * Sort n items, and check the result.
+ */
+{
+   int rtn= -1;
+   PTRVEC vec;
+   struct item *itemArr= malloc((n + 1) * sizeof(*itemArr));
+   unsigned i,
+            nKeys= 1 + rand() % 1000,
+            nPre= rand() % (n + 1);
+
+   PTRVEC_constructor(&vec, 1 + rand() % 64);
+
+   /* Move head along, so the items wrap around the ring */
+   for(i= 0; i < nPre; ++i)
+      PTRVEC_addTail(&vec, itemArr + n);
+   for(i= 0; i < nPre; ++i)
+      PTRVEC_remHead(&vec);
+
+   for(i= 0; i < n; ++i) {
+      itemArr[i].key= rand() % nKeys;
+      itemArr[i].seq= i;
+      PTRVEC_addTail(&vec, itemArr + i);
+   }
+
+   if(is_stable)
+      PTRVEC_stableSort(&vec, item_cmp, nThreads);
+   else
+      PTRVEC_sort(&vec, item_cmp);
+
+   if(PTRVEC_numItems(&vec) != n)
+      goto abort;
+
+   const struct item *it, *prev= NULL;
+   PTRVEC_loopFwd(&vec, i, it) {
+      if(prev && (prev->key > it->key || (is_stable && prev->key == it->key && prev->seq > it->seq)))
+         goto abort;
+      prev= it;
+   }
+
+   rtn= 0;
+abort:
+   if(rtn)
+      fprintf(stderr, "FAIL: %s of %u items on %u threads\n", is_stable ? "PTRVEC_stableSort()" : "PTRVEC_sort()", n, nThreads);
+   PTRVEC_destructor(&vec);
+   free(itemArr);
+   return rtn;
+}
+
+int
+main(void)
+{
+   unsigned t;
+
+   srand(7);
+
+   /* Small ones, which stay on one thread */
+   for(t= 0; t < 2000; ++t) {
+      if(check(rand() % 300, rand() % 9, t & 1))
+         return 1;
+   }
+
+   /* Big enough to be split across threads */
+   for(t= 0; t < 12; ++t) {
+      if(check(100000 + rand() % 600000, 1 + t % 8, 1))
+         return 1;
+   }
+
+   printf("ptrvec sort: all in order, equal keys kept in order by PTRVEC_stableSort()\n");
+   return 0;
+}
@@ -0,0 +1,211 @@
+/************************************************************
+ * Check where a STR keeps its string: in the buffer inside
+ * the STR while it fits, then on the heap, or in the ARENA
+ * for one constructed with STR_arena_constructor().
+ *
+ * Random appends, by each of STR_append(), STR_putc() and
+ * STR_sprintf(), are compared with a plain copy, for strings
+ * which end either side of STR_SSO_SZ. Arena STRs are then
+ * recycled after ARENA_reset() and used again.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "str.h"
+
+static int N_fail;
+
+static int
+in_arena(const ARENA *arena, const char *p)
+/***********************************************
+ * Does p point into one of arena's chunks?
+ */
+{
+   const struct arena_chunk *ch;
+   for(ch= arena->head; ch; ch= ch->next) {
+      if(ch->mem <= p && p < ch->end)
+         return 1;
+   }
+   return 0;
+}
+
+static const char*
+where(const STR *sb, const ARENA *arena)
+/***********************************************
+ * Name what holds sb's buffer.
+ */
+{
+   if(sb->buf == sb->sso)
+      return "sso";
+   if(arena && in_arena(arena, sb->buf))
+      return "arena";
+   return "heap";
+}
+
+static void
+fill(STR *sb, char *want, size_t len)
+/***********************************************
+ * Append random text to sb until it is len bytes
+ * long, keeping a copy in want.
+ */
+{
+   size_t n;
+   for(n= STR_len(sb); n < len;) {
+
+      char buf[16];
+      size_t i,
+             chunk= 1 + rand() % 15;
+      if(chunk > len - n)
+         chunk= len - n;
+      for(i= 0; i < chunk; ++i)
+         buf[i]= 'a' + rand() % 26;
+      buf[chunk]= '\0';
+
+      switch(rand() % 3) {
+         case 0:
+            STR_append(sb, buf, chunk);
+            break;
+
+         case 1:
+            for(i= 0; i < chunk; ++i)
+               STR_putc(sb, buf[i]);
+            break;
+
+         default:
+            STR_sprintf(sb, "%s", buf);
+            break;
+      }
+      memcpy(want + n, buf, chunk);
+      n += chunk;
+   }
+   want[n]= '\0';
+}
+
+static const char*
+placeFor(size_t len, const char *big)
+/***********************************************
+ * Where a string of len bytes belongs. Exactly
+ * filling sso may or may not move it, depending
+ * on how it was appended.
+ */
+{
+   if(len < STR_SSO_SZ - 1)
+      return "sso";
+   if(len >= STR_SSO_SZ)
+      return big;
+   return NULL;
+}
+
+static void
+expect(const char *what, const STR *sb, const char *want, const ARENA *arena, const char *place)
+/***********************************************
+ * Complain unless sb holds want, in place if
+ * that is not NULL.
+ */
+{
+   if(STR_len(sb) != strlen(want) || strcmp(STR_str(sb), want)) {
+      fprintf(stderr, "FAIL: %s: %zu bytes \"%.20s...\", not %zu bytes \"%.20s...\"\n",
+            what, STR_len(sb), STR_str(sb), strlen(want), want);
+      ++N_fail;
+   }
+
+   if(place && strcmp(where(sb, arena), place)) {
+      fprintf(stderr, "FAIL: %s: %zu bytes in %s, not %s\n", what, STR_len(sb), where(sb, arena), place);
+      ++N_fail;
+   }
+}
+
+int
+main(void)
+{
+   char want[4096];
+   unsigned i;
+   size_t len;
+
+   srand(25);
+
+   /* Lengths near the end of sso, and well past it */
+   static const size_t lenArr[]= {0, 1, STR_SSO_SZ - 2, STR_SSO_SZ - 1, STR_SSO_SZ, STR_SSO_SZ + 1, 200, 4000};
+
+   for(i= 0; i < 20000; ++i) {
+
+      len= lenArr[i % 8];
+      const char *place= placeFor(len, "heap");
+
+      /* On the heap, starting in sso */
+      STR sb;
+      if(!STR_constructor(&sb, 1 + rand() % STR_SSO_SZ)) {
+         fprintf(stderr, "FAIL: STR_constructor()\n");
+         return 1;
+      }
+      expect("new STR", &sb, "", NULL, "sso");
+      fill(&sb, want, len);
+      expect("STR", &sb, want, NULL, place);
+
+      /* Once on the heap, it stays there */
+      STR_reset(&sb);
+      fill(&sb, want, rand() % (STR_SSO_SZ - 1));
+      expect("STR after STR_reset()", &sb, want, NULL, place);
+      STR_destructor(&sb);
+
+      /* On the heap from the start */
+      STR_constructor(&sb, STR_SSO_SZ + 1);
+      fill(&sb, want, len);
+      expect("big STR", &sb, want, NULL, "heap");
+      STR_destructor(&sb);
+   }
+
+   /* In an arena, starting in sso, with STR_recycle() each time the arena is reset */
+   ARENA arena;
+   ARENA_constructor(&arena, 1024);
+
+   STR sb;
+   STR_arena_constructor(&sb, STR_SSO_SZ, &arena);
+   expect("new arena STR", &sb, "", &arena, "sso");
+
+   int is_moved= 0;
+   for(i= 0; i < 20000; ++i) {
+
+      len= lenArr[rand() % 8];
+      fill(&sb, want, len);
+
+      /* Once in the arena, it stays there until recycled */
+      const char *place= is_moved ? "arena" : placeFor(len, "arena");
+      expect("arena STR", &sb, want, &arena, place);
+      if(sb.buf != sb.sso)
+         is_moved= 1;
+
+      /* Something else in the arena, as ATND objects are */
+      ARENA_strndup(&arena, want, rand() % (len + 1));
+
+      if(rand() % 4) {
+         STR_reset(&sb);
+      } else {
+         ARENA_reset(&arena);
+         STR_recycle(&sb);
+         expect("recycled arena STR", &sb, "", &arena, "sso");
+         is_moved= 0;
+      }
+   }
+   STR_destructor(&sb);
+
+   /* In the arena from the start, then back to sso */
+   STR_arena_constructor(&sb, 1000, &arena);
+   fill(&sb, want, 10);
+   expect("big arena STR", &sb, want, &arena, "arena");
+   ARENA_reset(&arena);
+   STR_recycle(&sb);
+   fill(&sb, want, 10);
+   expect("big arena STR, recycled", &sb, want, &arena, "sso");
+   STR_destructor(&sb);
+
+   ARENA_destructor(&arena);
+
+   if(N_fail)
+      return 1;
+
+   printf("STR: strings up to %zu bytes in sso, on the heap and in an arena, as expected\n", lenArr[7]);
+   return 0;
+}
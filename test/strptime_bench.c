@@ -0,0 +1,65 @@
+/************************************************************
+ * Time ical_strptime() and strptime() on a million random
+ * DATE-TIME values.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "util.h"
+
+#define N_VALUES 1000000
+#define N_ROUNDS 3
+
+static double
+now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int
+main(void)
+{
+   static char valArr[N_VALUES][17];
+   unsigned i, r;
+   long sum= 0;
+
+   srand(1);
+   for(i= 0; i < N_VALUES; ++i)
+      sprintf(valArr[i], "%04d%02d%02dT%02d%02d%02dZ", 1970 + rand() % 100, 1 + rand() % 12,
+            1 + rand() % 28, rand() % 24, rand() % 60, rand() % 60);
+
+   double best_ref= 1e9,
+          best_ical= 1e9;
+
+   for(r= 0; r < N_ROUNDS; ++r) {
+
+      struct tm tm;
+      memset(&tm, 0, sizeof(tm));
+
+      double t0= now();
+      for(i= 0; i < N_VALUES; ++i) {
+         if(strptime(valArr[i], "%Y%m%dT%H%M%S", &tm))
+            sum += tm.tm_sec;
+      }
+      double t1= now();
+      for(i= 0; i < N_VALUES; ++i) {
+         if(ical_strptime(valArr[i], &tm))
+            sum += tm.tm_sec;
+      }
+      double t2= now();
+
+      if(t1 - t0 < best_ref) best_ref= t1 - t0;
+      if(t2 - t1 < best_ical) best_ical= t2 - t1;
+   }
+
+   printf("strptime()       %6.1f ns each\n", best_ref * 1e9 / N_VALUES);
+   printf("ical_strptime()  %6.1f ns each  (%.1fx)\n", best_ical * 1e9 / N_VALUES, best_ref / best_ical);
+
+   /* Keep the loops from being optimized away */
+   return sum < 0;
+}
@@ -0,0 +1,147 @@
+/************************************************************
+ * Check ical_strptime() against strptime() + timegm(), on
+ * valid DATE and DATE-TIME values, and on those values with
+ * bytes replaced, cut short, or followed by 'Z'.
+ *
+ * ical_strptime() is stricter than strptime() on purpose:
+ * every field must be all digits, with no spaces or short
+ * fields, and a second of 61 is refused. The reference
+ * applies the same rules on top of strptime().
+ */
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "util.h"
+
+static unsigned long N_checked,
+                     N_valid;
+
+static const char*
+ref_strptime(const char *src, struct tm *tm)
+/***********************************************
+ * What ical_strptime() should do, by way of
+ * strptime().
+ */
+{
+   int is_dt= 'T' == src[8];
+   size_t len= is_dt ? 15 : 8,
+          i;
+
+   if(strnlen(src, len) < len)
+      return NULL;
+
+   for(i= 0; i < len; ++i) {
+      if(8 == i && is_dt) continue;
+      if(!isdigit((unsigned char)src[i]))
+         return NULL;
+   }
+
+   const char *rtn= strptime(src, is_dt ? "%Y%m%dT%H%M%S" : "%Y%m%d", tm);
+   if(rtn != src + len || tm->tm_sec > 60)
+      return NULL;
+
+   return rtn;
+}
+
+static void
+check(const char *src)
+/***********************************************
+ * Compare the two on src, and exit on a difference.
+ */
+{
+   struct tm a, b;
+   memset(&a, 0, sizeof(a));
+   memset(&b, 0, sizeof(b));
+
+   const char *ra= ical_strptime(src, &a),
+              *rb= ref_strptime(src, &b);
+
+   ++N_checked;
+   if(ra != rb)
+      goto bad;
+
+   if(!ra)
+      return;
+
+   ++N_valid;
+   if(a.tm_year != b.tm_year || a.tm_mon != b.tm_mon || a.tm_mday != b.tm_mday ||
+      a.tm_hour != b.tm_hour || a.tm_min != b.tm_min || a.tm_sec != b.tm_sec ||
+      timegm(&a) != timegm(&b))
+      goto bad;
+
+   return;
+
+bad:
+   fprintf(stderr, "FAIL: \"%s\": ical_strptime() %s, strptime() %s\n",
+         src, ra ? "accepts" : "refuses", rb ? "accepts" : "refuses");
+   exit(1);
+}
+
+static void
+randomValue(char *buf, int is_dt)
+/***********************************************
+ * A valid DATE or DATE-TIME, with every field
+ * somewhere in its range.
+ */
+{
+   int n= sprintf(buf, "%04d%02d%02d", rand() % 10000, 1 + rand() % 12, 1 + rand() % 31);
+   if(is_dt)
+      sprintf(buf + n, "T%02d%02d%02d", rand() % 24, rand() % 60, rand() % 61);
+}
+
+int
+main(void)
+{
+   /* Bytes which might trip up a digit test */
+   static const char junk[]= "0123456789T Z:/-+\t\x7f\x80\xff" "abcxyz" "\x2f\x3a\x20";
+   char buf[32];
+   unsigned i, j;
+
+   srand(2);
+
+   /* Edges of each field */
+   static const char *const edgeArr[]= {
+      "00000101", "99991231", "20240229", "20240100", "20240001", "20241301", "20240132",
+      "20240101T000000", "20240101T235960", "20240101T235961", "20240101T240000",
+      "20240101T236000", "20240101T000060Z", "20240101T120000Z",
+      "2024010", "20240101T", "20240101T12", "20240101T12000", "", "T",
+   };
+   for(i= 0; i < sizeof(edgeArr) / sizeof(edgeArr[0]); ++i)
+      check(edgeArr[i]);
+
+   for(i= 0; i < 2000000; ++i) {
+
+      int is_dt= rand() & 1;
+      randomValue(buf, is_dt);
+      size_t len= strlen(buf);
+
+      switch(rand() % 4) {
+
+         case 0: /* As is */
+            break;
+
+         case 1: /* Replace a byte or two */
+            for(j= 1 + rand() % 2; j; --j)
+               buf[rand() % len]= junk[rand() % (sizeof(junk) - 1)];
+            break;
+
+         case 2: /* Cut short */
+            buf[rand() % len]= '\0';
+            break;
+
+         case 3: /* UTC, or something else after it */
+            buf[len]= rand() & 1 ? 'Z' : junk[rand() % (sizeof(junk) - 1)];
+            buf[len + 1]= '\0';
+            break;
+      }
+
+      check(buf);
+   }
+
+   printf("ical_strptime: %lu values, %lu valid, all agree with strptime()\n", N_checked, N_valid);
+   return 0;
+}
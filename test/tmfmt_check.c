@@ -0,0 +1,121 @@
+/************************************************************
+ * Check TMFMT_render() against localtime_r() + strftime(),
+ * with TZ set to the zone being rendered in.
+ *
+ * Each zone is tried as the local timezone and as a TZIF,
+ * on random times from 1970 to 2099, and on runs of times
+ * close together, the way a report's times are, so that
+ * both the cached days and the slow path get used.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tmfmt.h"
+#include "tzif.h"
+
+static const char *const ZoneArr[]= {
+   "America/New_York",
+   "America/St_Johns",     /* Half hour offset */
+   "Europe/Berlin",
+   "Australia/Sydney",     /* Southern hemisphere */
+   "Australia/Lord_Howe",  /* Half hour of DST */
+   "Asia/Kolkata",
+};
+
+static const char *const FmtArr[]= {
+   "%H:%M %A %B %d, %Y %Z",   /* What reports use */
+   "%Y-%m-%d %T",
+   "%k:%M:%S %a %Z",
+   "%R%%H %j",
+   "%I:%M %p",                /* Never cached */
+};
+
+static unsigned long N_checked;
+
+static void
+check(TMFMT *tf, const char *zone, const char *fmt, time_t when)
+/***********************************************
+ * Compare the two at when, and exit on a difference.
+ */
+{
+   char got[128],
+        want[128];
+   struct tm tm;
+
+   size_t got_len= TMFMT_render(tf, got, sizeof(got), when);
+
+   localtime_r(&when, &tm);
+   size_t want_len= strftime(want, sizeof(want), fmt, &tm);
+
+   ++N_checked;
+   if(got_len != want_len || strcmp(got, want)) {
+      fprintf(stderr, "FAIL: %s \"%s\" at %ld: \"%s\", not \"%s\"\n", zone, fmt, (long)when, got, want);
+      exit(1);
+   }
+}
+
+static time_t
+randomTime(void)
+/***********************************************
+ * Any second from 1970 to 2099.
+ */
+{
+   return ((time_t)rand() << 16 ^ rand()) % 4102444800;
+}
+
+int
+main(void)
+{
+   unsigned i, j, k, n;
+
+   srand(12);
+
+   for(i= 0; i < sizeof(ZoneArr) / sizeof(ZoneArr[0]); ++i) {
+
+      const char *zone= ZoneArr[i];
+      const TZIF *tz= TZIF_get(zone);
+      if(!tz) {
+         fprintf(stderr, "FAIL: cannot load %s\n", zone);
+         return 1;
+      }
+
+      setenv("TZ", zone, 1);
+      tzset();
+
+      for(j= 0; j < sizeof(FmtArr) / sizeof(FmtArr[0]); ++j) {
+
+         TMFMT local,
+               other;
+         if(!TMFMT_constructor(&local, FmtArr[j], NULL) ||
+            !TMFMT_constructor(&other, FmtArr[j], tz))
+         {
+            fprintf(stderr, "FAIL: cannot construct TMFMT\n");
+            return 1;
+         }
+
+         for(k= 0; k < 4000; ++k) {
+
+            time_t when= randomTime();
+            check(&local, zone, FmtArr[j], when);
+            check(&other, zone, FmtArr[j], when);
+
+            /* A run of times within a few months, some hours apart */
+            for(n= 0; n < 8; ++n) {
+               when += rand() % (14 * 86400);
+               check(&local, zone, FmtArr[j], when);
+               check(&other, zone, FmtArr[j], when);
+            }
+         }
+
+         TMFMT_destructor(&local);
+         TMFMT_destructor(&other);
+      }
+   }
+
+   printf("TMFMT_render: %lu times in %zu zones, all agree with strftime()\n",
+         N_checked, sizeof(ZoneArr) / sizeof(ZoneArr[0]));
+   return 0;
+}
@@ -0,0 +1,159 @@
+/************************************************************
+ * Check TZIF_mktime() against the C library, by way of
+ * localtime_r() and mktime() with TZ set to the same zone.
+ *
+ * For each local time, every offset in use nearby gives a
+ * candidate UTC time; the C library says which candidates
+ * really show that local time. With one, TZIF_mktime() and
+ * mktime() must both find it. With two, when clocks fall
+ * back, TZIF_mktime() must pick the earlier. With none,
+ * when clocks spring forward, it must use the old offset.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tz_xref.h"
+#include "tzif.h"
+
+static const char *const ZoneArr[]= {
+   "America/New_York",
+   "America/St_Johns",  /* Half hour offset */
+   "Europe/Berlin",
+   "Europe/Dublin",     /* Negative DST in the TZif file */
+   "Australia/Sydney",  /* Southern hemisphere */
+   "Pacific/Chatham",   /* Changes at 02:45 */
+   "Asia/Kolkata",      /* No DST */
+   "UTC",
+};
+
+static unsigned long N_checked,
+                     N_fold,
+                     N_gap;
+
+static long
+gmtoff(time_t when)
+/***********************************************
+ * The C library's offset at when.
+ */
+{
+   struct tm tm;
+   localtime_r(&when, &tm);
+   return tm.tm_gmtoff;
+}
+
+static int
+shows(time_t when, time_t local)
+/***********************************************
+ * Does the C library show local at when?
+ */
+{
+   struct tm tm;
+   localtime_r(&when, &tm);
+   return timegm(&tm) == local;
+}
+
+static void
+check(const char *zone, const TZIF *tz, time_t local)
+/***********************************************
+ * Check the local time local, in seconds since
+ * the epoch as if it were UTC, and exit on a
+ * difference.
+ */
+{
+   struct tm tm;
+   gmtime_r(&local, &tm);
+
+   /* The offsets which might apply */
+   long old_off= gmtoff(local - 86400),
+        new_off= gmtoff(local + 86400);
+   time_t candArr[2];
+   unsigned nCands= 0;
+
+   if(shows(local - old_off, local))
+      candArr[nCands++]= local - old_off;
+   if(new_off != old_off && shows(local - new_off, local))
+      candArr[nCands++]= local - new_off;
+
+   time_t want,
+          got= TZIF_mktime(tz, &tm);
+
+   ++N_checked;
+   switch(nCands) {
+
+      case 1: {
+         want= candArr[0];
+
+         struct tm mk= tm;
+         mk.tm_isdst= -1;
+         if(mktime(&mk) != want) {
+            fprintf(stderr, "FAIL: %s %.24s: mktime() gives %ld, not %ld\n",
+                  zone, asctime(&tm), (long)mktime(&mk), (long)want);
+            exit(1);
+         }
+      } break;
+
+      case 2:
+         ++N_fold;
+         want= candArr[0] < candArr[1] ? candArr[0] : candArr[1];
+         break;
+
+      default:
+         ++N_gap;
+         want= local - old_off;
+         break;
+   }
+
+   if(got != want) {
+      fprintf(stderr, "FAIL: %s %.24s (%u candidates): TZIF_mktime() gives %ld, not %ld\n",
+            zone, asctime(&tm), nCands, (long)got, (long)want);
+      exit(1);
+   }
+}
+
+int
+main(void)
+{
+   unsigned i, j;
+
+   srand(9);
+
+   for(i= 0; i < sizeof(ZoneArr) / sizeof(ZoneArr[0]); ++i) {
+
+      const char *zone= ZoneArr[i];
+      const TZIF *tz= TZIF_get(zone);
+      if(!tz) {
+         fprintf(stderr, "FAIL: cannot load %s\n", zone);
+         return 1;
+      }
+
+      setenv("TZ", zone, 1);
+      tzset();
+
+      /* Every quarter hour for some years, to hit every change of offset */
+      time_t t,
+             from= 1704067200, /* 2024-01-01 */
+             to= 1924992000;   /* 2031-01-01 */
+      for(t= from; t < to; t += 900)
+         check(zone, tz, t);
+
+      /* Any second, 1970 to 2099, which goes past the transitions
+       * in the file and onto the rule in its footer
+       */
+      for(j= 0; j < 100000; ++j)
+         check(zone, tz, ((time_t)rand() << 16 ^ rand()) % 4102444800);
+   }
+
+   /* A zone found through Ms2Posix[] is looked up once, then kept */
+   const struct tz_xref *xref= tz_xref_find("Samoa Standard Time", 19);
+   if(!xref || tz_xref_zone(xref) != TZIF_get("Pacific/Apia") || tz_xref_zone(xref) != tz_xref_zone(xref)) {
+      fprintf(stderr, "FAIL: tz_xref_zone() for \"Samoa Standard Time\"\n");
+      return 1;
+   }
+
+   printf("TZIF_mktime: %lu local times in %zu zones, %lu repeated, %lu skipped, all as expected\n",
+         N_checked, sizeof(ZoneArr) / sizeof(ZoneArr[0]), N_fold, N_gap);
+   return 0;
+}
@@ -0,0 +1,138 @@
+/************************************************************
+ * Check INBUF_getLine() against the plain unfolding loop it
+ * replaced, on random text heavy with newlines, carriage
+ * returns, spaces and tabs, with lines long and short. Each
+ * unfolder this CPU can run is checked in turn; inbuf.c is
+ * included so they can be picked directly.
+ */
+#include "inbuf.c"
+
+#include <stdio.h>
+
+static char*
+ref_getLine(char *buf, size_t buf_len, size_t *pos, size_t *len)
+/***********************************************
+ * The unfolding loop from before the SIMD scanners.
+ */
+{
+   char *end= buf + buf_len,
+        *line= buf + *pos,
+        *wr= line,
+        *p= line;
+
+   if(p >= end)
+      return NULL;
+
+   for(;;) {
+      char *nl= memchr(p, '\n', end - p),
+           *seg_end= nl ? nl : end;
+
+      if(seg_end > p && '\r' == seg_end[-1])
+         --seg_end;
+
+      size_t seg_len= seg_end - p;
+      if(wr != p)
+         memmove(wr, p, seg_len);
+      wr += seg_len;
+
+      if(!nl) {
+         p= end;
+         break;
+      }
+
+      p= nl + 1;
+      if(p < end && (' ' == *p || '\t' == *p)) {
+         ++p;
+         continue;
+      }
+      break;
+   }
+
+   *pos= p - buf;
+
+   while(wr > line && isspace((unsigned char)wr[-1]))
+      --wr;
+   *wr= '\0';
+
+   *len= wr - line;
+   return line;
+}
+
+static int
+check(INBUF *in, const char *name)
+/***********************************************
+ * Run the random inputs through in.
+ */
+{
+   static const char alpha[]= "\n\n\r  \tabcdefgh:;=XYZ";
+   unsigned t;
+   unsigned long nLines= 0;
+
+   srand(16);
+
+   for(t= 0; t < 200000; ++t) {
+
+      /* Sometimes long runs without a newline, to cover whole blocks */
+      size_t len= rand() % (t & 7 ? 200 : 2000),
+             i;
+      unsigned runs= rand() % 4;
+      char *src= malloc(len + 1),
+           *ref= malloc(len + 1);
+
+      for(i= 0; i < len; ++i)
+         src[i]= runs && rand() % 64 ? 'a' + rand() % 26 : alpha[rand() % (sizeof(alpha) - 1)];
+
+      memcpy(ref, src, len);
+      INBUF_openBuf(in, src, len);
+
+      size_t pos= 0;
+      for(;;) {
+         size_t got_len= 0, ref_len= 0;
+         char *got= INBUF_getLine(in, &got_len),
+              *want= ref_getLine(ref, len, &pos, &ref_len);
+
+         if(!got != !want || (got && (got_len != ref_len || memcmp(got, want, got_len)))) {
+            fprintf(stderr, "FAIL: %s: case %u, line %lu differs\n", name, t, nLines);
+            return -1;
+         }
+         if(!got)
+            break;
+         ++nLines;
+      }
+
+      free(src);
+      free(ref);
+   }
+
+   printf("unfold %s: %lu lines from 200000 random inputs match the plain loop\n", name, nLines);
+   return 0;
+}
+
+int
+main(void)
+{
+   INBUF in;
+
+   /* Picks the unfolder for this CPU, which is then overridden */
+   INBUF_constructor(&in);
+
+   Unfold= unfold_scalar;
+   if(check(&in, "scalar"))
+      return 1;
+
+#ifdef HAVE_X86
+   if(__builtin_cpu_supports("sse2")) {
+      Unfold= unfold_sse2;
+      if(check(&in, "sse2"))
+         return 1;
+   }
+   if(__builtin_cpu_supports("avx2")) {
+      Unfold= unfold_avx2;
+      if(check(&in, "avx2"))
+         return 1;
+   }
+#endif
+
+   INBUF_destructor(&in);
+   return 0;
+}
@@ -0,0 +1,196 @@
+/************************************************************
+ * Check zones compiled from VTIMEZONE components: a quoted
+ * TZID, times skipped and repeated when clocks change, the
+ * cache of good and bad definitions, and its size limit.
+ *
+ * A definition of US Eastern time must convert every quarter
+ * hour from 2024 to 2030 the same as America/New_York, and an
+ * invite using it through a TZID not in Ms2Posix[] must parse
+ * to the same times.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tzif.h"
+#include "vcalendar.h"
+
+#define EASTERN \
+   "TZID:\"Nowhere Standard Time\"\n" \
+   "BEGIN:STANDARD\n" \
+   "DTSTART:16010101T020000\n" \
+   "TZOFFSETFROM:-0400\n" \
+   "TZOFFSETTO:-0500\n" \
+   "RRULE:FREQ=YEARLY;BYDAY=1SU;BYMONTH=11\n" \
+   "END:STANDARD\n" \
+   "BEGIN:DAYLIGHT\n" \
+   "DTSTART:16010101T020000\n" \
+   "TZOFFSETFROM:-0500\n" \
+   "TZOFFSETTO:-0400\n" \
+   "RRULE:FREQ=YEARLY;BYDAY=2SU;BYMONTH=3\n" \
+   "END:DAYLIGHT\n"
+
+/* Daylight saving time ends, which a POSIX rule cannot say */
+#define UNUSABLE \
+   "TZID:Odd\n" \
+   "BEGIN:STANDARD\n" \
+   "DTSTART:16010101T020000\n" \
+   "TZOFFSETTO:+0100\n" \
+   "RRULE:FREQ=YEARLY;BYDAY=-1SU;BYMONTH=10\n" \
+   "END:STANDARD\n" \
+   "BEGIN:DAYLIGHT\n" \
+   "DTSTART:16010101T020000\n" \
+   "TZOFFSETTO:+0200\n" \
+   "RRULE:FREQ=YEARLY;BYDAY=-1SU;BYMONTH=3;UNTIL=20301231T000000Z\n" \
+   "END:DAYLIGHT\n"
+
+static const char Invite[]=
+   "BEGIN:VCALENDAR\r\n"
+   "BEGIN:VTIMEZONE\r\n"
+   "TZID:\"Nowhere Standard Time\"\r\n"
+   "BEGIN:STANDARD\r\n"
+   "DTSTART:16010101T020000\r\n"
+   "TZOFFSETFROM:-0400\r\n"
+   "TZOFFSETTO:-0500\r\n"
+   "RRULE:FREQ=YEARLY;BYDAY=1SU;BYMONTH=11\r\n"
+   "END:STANDARD\r\n"
+   "BEGIN:DAYLIGHT\r\n"
+   "DTSTART:16010101T020000\r\n"
+   "TZOFFSETFROM:-0500\r\n"
+   "TZOFFSETTO:-0400\r\n"
+   "RRULE:FREQ=YEARLY;BYDAY=2SU;BYMONTH=3\r\n"
+   "END:DAYLIGHT\r\n"
+   "END:VTIMEZONE\r\n"
+   "BEGIN:VEVENT\r\n"
+   "DTSTART;TZID=\"Nowhere Standard Time\":20240310T023000\r\n"
+   "DTEND;TZID=\"Nowhere Standard Time\":20241103T013000\r\n"
+   "SUMMARY:Skipped and repeated\r\n"
+   "END:VEVENT\r\n"
+   "END:VCALENDAR\r\n";
+
+static int N_fail;
+
+static void
+expect(const char *what, time_t got, time_t want)
+/***********************************************
+ * Complain if got is not want.
+ */
+{
+   if(got == want)
+      return;
+
+   fprintf(stderr, "FAIL: %s: %ld, not %ld\n", what, (long)got, (long)want);
+   ++N_fail;
+}
+
+static time_t
+utc(const char *str)
+/***********************************************
+ * A UTC time, YYYYmmddTHHMMSS.
+ */
+{
+   struct tm tm;
+   memset(&tm, 0, sizeof(tm));
+   strptime(str, "%Y%m%dT%H%M%S", &tm);
+   return timegm(&tm);
+}
+
+static time_t
+vtz_mktime(const TZIF *tz, const char *str)
+/***********************************************
+ * Convert local time str, YYYYmmddTHHMMSS, in tz.
+ */
+{
+   struct tm tm;
+   memset(&tm, 0, sizeof(tm));
+   strptime(str, "%Y%m%dT%H%M%S", &tm);
+   return TZIF_mktime(tz, &tm);
+}
+
+int
+main(void)
+{
+   const TZIF *vtz= TZIF_getVTIMEZONE(EASTERN),
+              *ny= TZIF_get("America/New_York");
+
+   if(!vtz || !ny) {
+      fprintf(stderr, "FAIL: cannot get the zones\n");
+      return 1;
+   }
+
+   if(strcmp(vtz->name, "Nowhere Standard Time")) {
+      fprintf(stderr, "FAIL: TZID is \"%s\"\n", vtz->name);
+      ++N_fail;
+   }
+
+   /* The same definition is compiled once */
+   if(TZIF_getVTIMEZONE(EASTERN) != vtz) {
+      fprintf(stderr, "FAIL: definition compiled twice\n");
+      ++N_fail;
+   }
+
+   /* Skipped: the old offset; repeated: the earlier time */
+   expect("2024-03-10 02:30, skipped", vtz_mktime(vtz, "20240310T023000"), utc("20240310T073000"));
+   expect("2024-11-03 01:30, repeated", vtz_mktime(vtz, "20241103T013000"), utc("20241103T053000"));
+   expect("2024-11-03 02:00, after", vtz_mktime(vtz, "20241103T020000"), utc("20241103T070000"));
+
+   /* Agrees with the TZif file where the rules are the same */
+   time_t t;
+   unsigned long n= 0;
+   for(t= 1704067200; t < 1924992000; t += 900, ++n) {
+      struct tm tm;
+      gmtime_r(&t, &tm);
+      time_t a= TZIF_mktime(vtz, &tm),
+             b= TZIF_mktime(ny, &tm);
+      if(a != b) {
+         fprintf(stderr, "FAIL: %.24s: %ld from VTIMEZONE, %ld from America/New_York\n",
+               asctime(&tm), (long)a, (long)b);
+         return 1;
+      }
+
+      struct tm va, vb;
+      TZIF_localtime(vtz, t, &va);
+      TZIF_localtime(ny, t, &vb);
+      if(timegm(&va) != timegm(&vb)) {
+         fprintf(stderr, "FAIL: localtime at %ld differs\n", (long)t);
+         return 1;
+      }
+   }
+
+   /* A definition which cannot be used is remembered as such */
+   if(TZIF_getVTIMEZONE(UNUSABLE) || TZIF_getVTIMEZONE(UNUSABLE)) {
+      fprintf(stderr, "FAIL: unusable definition accepted\n");
+      ++N_fail;
+   }
+
+   /* An invite using the zone by a quoted TZID which is not in Ms2Posix[] */
+   VCAL *vc= vcalendar_new();
+   struct vcalendar_event ev;
+   if(!vc || vcalendar_parse(vc, Invite, sizeof(Invite) - 1) || vcalendar_event(vc, &ev)) {
+      fprintf(stderr, "FAIL: cannot parse the invite\n");
+      return 1;
+   }
+   expect("invite DTSTART, skipped", ev.start, utc("20240310T073000"));
+   expect("invite DTEND, repeated", ev.end, utc("20241103T053000"));
+   vcalendar_free(vc);
+
+   /* Once the cache is full, new definitions are refused, and old ones still work */
+   char def[sizeof(EASTERN) + 32];
+   unsigned i;
+   for(i= 0; i < TZIF_VTZ_MAX; ++i) {
+      snprintf(def, sizeof(def), "%sX-SERIAL:%u\n", EASTERN, i);
+      TZIF_getVTIMEZONE(def);
+   }
+   if(TZIF_getVTIMEZONE(def) || TZIF_getVTIMEZONE(EASTERN) != vtz) {
+      fprintf(stderr, "FAIL: cache limit\n");
+      ++N_fail;
+   }
+
+   if(N_fail)
+      return 1;
+
+   printf("VTIMEZONE: %lu quarter hours agree with America/New_York, gaps, overlaps, invite and cache as expected\n", n);
+   return 0;
+}
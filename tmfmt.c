@@ -0,0 +1,297 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+
+#include "tmfmt.h"
+#include "util.h"
+
+#define SECS_PER_DAY 86400
+
+/* Conversions which only depend on the time of day */
+#define TOD_CONVERSIONS "HMSkRT"
+
+/* Conversions which vary within a day in some other way, or modify another */
+#define UNCACHEABLE_CONVERSIONS "IlprXcs+_-0^#EO123456789"
+
+static int fillDay(TMFMT *self, struct tmfmt_day *day, time_t when);
+static struct tm *toLocal(const TMFMT *self, time_t when, struct tm *rtnBuf);
+
+TMFMT*
+TMFMT_constructor(TMFMT *self, const char *fmt, const TZIF *tz)
+/***********************************************
+ * Construct a TMFMT for the strftime() format fmt.
+ */
+{
+   TMFMT *rtn= NULL;
+
+   if(!self) return NULL;
+   memset(self, 0, sizeof(*self));
+   self->tz= tz;
+
+   size_t fmt_len= strlen(fmt);
+
+   /* At most one piece per conversion, plus one */
+   unsigned maxPieces= 1;
+   const char *p;
+   for(p= fmt; *p; ++p)
+      if('%' == *p) ++maxPieces;
+
+   if(!(self->fmt= strdup(fmt)) ||
+      !(self->pieceArr= calloc(maxPieces, sizeof(*self->pieceArr))) ||
+      !(self->todArr= calloc(maxPieces, sizeof(*self->todArr))))
+   {
+      sys_eprintf("ERROR: memory allocation failed");
+      goto abort;
+   }
+
+   /*--- Split fmt at the time of day conversions ---*/
+   self->is_cacheable= 1;
+   const char *start= fmt;
+   for(p= fmt; *p; ++p) {
+
+      if('%' != *p)
+         continue;
+
+      char c= p[1];
+      if(!c)
+         break;
+
+      if(strchr(UNCACHEABLE_CONVERSIONS, c)) {
+         self->is_cacheable= 0;
+
+      } else if(strchr(TOD_CONVERSIONS, c)) {
+
+         if(!(self->pieceArr[self->nPieces]= strndup(start, p - start))) {
+            sys_eprintf("ERROR: strndup() failed");
+            goto abort;
+         }
+         self->todArr[self->nPieces++]= c;
+         start= p + 2;
+      }
+
+      /* Skip the conversion character, so "%%H" isn't taken for "%H" */
+      ++p;
+   }
+
+   if(!(self->pieceArr[self->nPieces++]= strndup(start, fmt + fmt_len - start))) {
+      sys_eprintf("ERROR: strndup() failed");
+      goto abort;
+   }
+
+   if(self->nPieces > sizeof(self->dayArr[0].endArr))
+      self->is_cacheable= 0;
+
+   /* Pick up the local timezone */
+   if(!tz)
+      tzset();
+
+   rtn= self;
+abort:
+   return rtn;
+}
+
+void*
+TMFMT_destructor(TMFMT *self)
+/***********************************************
+ * Destruct a TMFMT.
+ */
+{
+   if(self->pieceArr) {
+      unsigned i;
+      for(i= 0; i < self->nPieces; ++i)
+         free(self->pieceArr[i]);
+      free(self->pieceArr);
+   }
+   if(self->todArr) free(self->todArr);
+   if(self->fmt) free(self->fmt);
+   return self;
+}
+
+static long
+day_of(time_t when, long gmtoff)
+/***********************************************
+ * Local day number of when, rounding down.
+ */
+{
+   long long local= (long long)when + gmtoff;
+   return (long)((local >= 0 ? local : local - (SECS_PER_DAY - 1)) / SECS_PER_DAY);
+}
+
+static char*
+put2(char *dst, unsigned n, char pad)
+/***********************************************
+ * Write n, which is < 100, as two characters.
+ */
+{
+   dst[0]= n >= 10 ? (char)('0' + n / 10) : pad;
+   dst[1]= '0' + n % 10;
+   return dst + 2;
+}
+
+size_t
+TMFMT_render(TMFMT *self, char *buf, size_t buf_sz, time_t when)
+/***********************************************
+ * Render when in our zone into buf.
+ */
+{
+   if(!buf_sz)
+      return 0;
+
+   struct tmfmt_day *day= NULL;
+
+   if(self->is_cacheable) {
+
+      day= self->dayArr + (day_of(when, self->guess_off) & (TMFMT_N_DAYS - 1));
+
+      /* Not the day we want? Figure out which it is */
+      if(when < day->utc_lo || when >= day->utc_hi) {
+
+         struct tm tm;
+         if(!toLocal(self, when, &tm))
+            goto slow;
+
+         day= self->dayArr + (day_of(when, tm.tm_gmtoff) & (TMFMT_N_DAYS - 1));
+         if(fillDay(self, day, when))
+            goto slow;
+      }
+
+      self->guess_off= day->gmtoff;
+
+      /*--- Stitch together the day's pieces and the time of day ---*/
+      unsigned secs= when - day->utc_lo,
+               hour= secs / 3600,
+               min= secs / 60 % 60,
+               sec= secs % 60;
+
+      char tod[8],
+           *dst= buf,
+           *end= buf + buf_sz - 1;
+      unsigned i,
+               from= 0;
+
+      for(i= 0; i < self->nPieces; from= day->endArr[i++]) {
+
+         size_t len= day->endArr[i] - from;
+         if(len > (size_t)(end - dst))
+            goto toolong;
+         memcpy(dst, day->text + from, len);
+         dst += len;
+
+         char *t= tod;
+         switch(self->todArr[i]) {
+            case 'H': t= put2(t, hour, '0'); break;
+            case 'k': t= put2(t, hour, ' '); break;
+            case 'M': t= put2(t, min, '0'); break;
+            case 'S': t= put2(t, sec, '0'); break;
+            case 'R':
+            case 'T':
+               t= put2(t, hour, '0');
+               *t++= ':';
+               t= put2(t, min, '0');
+               if('T' == self->todArr[i]) {
+                  *t++= ':';
+                  t= put2(t, sec, '0');
+               }
+               break;
+         }
+
+         len= t - tod;
+         if(len > (size_t)(end - dst))
+            goto toolong;
+         memcpy(dst, tod, len);
+         dst += len;
+      }
+
+      *dst= '\0';
+      return dst - buf;
+
+toolong:
+      *buf= '\0';
+      return 0;
+   }
+
+slow:
+   {
+      struct tm tm;
+      *buf= '\0';
+      if(!toLocal(self, when, &tm))
+         return 0;
+      return strftime(buf, buf_sz, self->fmt, &tm);
+   }
+}
+
+unsigned
+TMFMT_renderArr(TMFMT *self, char *bufArr, size_t buf_sz, const time_t *whenArr, unsigned nWhens)
+/***********************************************
+ * Render each of whenArr[nWhens] into consecutive
+ * buffers of buf_sz bytes.
+ */
+{
+   unsigned i,
+            rtn= 0;
+
+   for(i= 0; i < nWhens; ++i)
+      if(TMFMT_render(self, bufArr + i * buf_sz, buf_sz, whenArr[i]))
+         ++rtn;
+
+   return rtn;
+}
+
+static int
+fillDay(TMFMT *self, struct tmfmt_day *day, time_t when)
+/***********************************************
+ * Render the pieces for the local day containing
+ * when into day. Returns 0 for success, -1 if the
+ * day can't be cached.
+ */
+{
+   struct tm tm, tm_lo, tm_hi;
+
+   /* Forget whatever was here */
+   day->utc_lo= day->utc_hi= 0;
+
+   if(!toLocal(self, when, &tm))
+      return -1;
+
+   time_t lo= when - (tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec),
+          hi= lo + SECS_PER_DAY;
+
+   /* The offset must hold from midnight to midnight */
+   if(!toLocal(self, lo, &tm_lo) || !toLocal(self, hi - 1, &tm_hi) ||
+      tm_lo.tm_gmtoff != tm.tm_gmtoff || tm_hi.tm_gmtoff != tm.tm_gmtoff ||
+      tm_lo.tm_mday != tm.tm_mday || tm_hi.tm_mday != tm.tm_mday ||
+      tm_lo.tm_hour || tm_lo.tm_min || tm_lo.tm_sec ||
+      23 != tm_hi.tm_hour || 59 != tm_hi.tm_min || 59 != tm_hi.tm_sec)
+      return -1;
+
+   size_t len= 0;
+   unsigned i;
+   for(i= 0; i < self->nPieces; ++i) {
+
+      /* strftime() returns 0 for an empty result as well as one which doesn't fit */
+      if(*self->pieceArr[i]) {
+         size_t n= strftime(day->text + len, sizeof(day->text) - len, self->pieceArr[i], &tm);
+         if(!n)
+            return -1;
+         len += n;
+      }
+      day->endArr[i]= len;
+   }
+
+   day->utc_lo= lo;
+   day->utc_hi= hi;
+   day->gmtoff= tm.tm_gmtoff;
+   return 0;
+}
+
+static struct tm*
+toLocal(const TMFMT *self, time_t when, struct tm *rtnBuf)
+/***********************************************
+ * Break down when in our zone.
+ */
+{
+   if(self->tz)
+      return TZIF_localtime(self->tz, when, rtnBuf);
+
+   return localtime_r(&when, rtnBuf);
+}
@@ -0,0 +1,113 @@
+/************************************************************
+ * Class to render many times in local time, or in the time of
+ * some other zone, with the same strftime() format, faster than
+ * localtime_r() + strftime() for each one.
+ *
+ * Everything in the format but the time of day (%H, %M, %S,
+ * %k, %R, %T) is the same all day, so it is rendered once per
+ * local day and kept in a small cache, along with the span of
+ * UTC the day covers. Rendering a time on a cached day is then
+ * just arithmetic and copying. Days on which the offset from
+ * UTC changes, and formats with anything else that varies
+ * within a day (%I, %p, %s, %c, ...), take the slow path.
+ */
+#ifndef TMFMT_H
+#define TMFMT_H
+
+#include <stddef.h>
+#include <time.h>
+
+#include "tzif.h"
+
+/* How many local days are kept; a power of 2 */
+#define TMFMT_N_DAYS 128
+
+/* Room for everything but the time of day */
+#define TMFMT_DAY_SZ 128
+
+typedef struct _TMFMT {
+
+   /* The whole format, for the slow path */
+   char *fmt;
+
+   /* Zone to render in, or NULL for local time */
+   const TZIF *tz;
+
+   /* Nonzero if days can be cached */
+   int is_cacheable;
+
+   /* fmt split at the time of day conversions: nPieces strftime()
+    * formats, with todArr[i] ('H', 'M', ...) following piece i.
+    */
+   char **pieceArr;
+   char *todArr;
+   unsigned nPieces;
+
+   /* Offset from UTC of the last day used, to guess the next one */
+   long guess_off;
+
+   struct tmfmt_day {
+
+      /* UTC span of the day, and its offset from UTC */
+      time_t utc_lo,
+             utc_hi;
+      long gmtoff;
+
+      /* Rendered pieces, and where each one ends */
+      char text[TMFMT_DAY_SZ];
+      unsigned char endArr[8];
+
+   } dayArr[TMFMT_N_DAYS];
+
+} TMFMT;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define TMFMT_create(p, fmt, tz) \
+  ((p)=(TMFMT_constructor((p)=malloc(sizeof(TMFMT)), fmt, tz) ? (p) : ( p ? realloc(TMFMT_destructor(p),0) : 0 )))
+TMFMT*
+TMFMT_constructor(TMFMT *self, const char *fmt, const TZIF *tz);
+/***********************************************
+ * Construct a TMFMT for the strftime() format fmt.
+ * Times are rendered in tz, or if it is NULL, the
+ * local timezone, which is whatever TZ says now.
+ *
+ * returns - pointer to the object, or NULL for failure.
+ */
+
+void*
+TMFMT_destructor(TMFMT *self);
+/***********************************************
+ * Destruct a TMFMT.
+ */
+
+#define TMFMT_destroy(p) \
+  do {if(TMFMT_destructor(p)) {free(p); p= NULL;}} while(0)
+
+size_t
+TMFMT_render(TMFMT *self, char *buf, size_t buf_sz, time_t when);
+/***********************************************
+ * Render when in our zone into buf, which holds
+ * buf_sz bytes, and is always null terminated.
+ *
+ * returns - the length of the result, or 0 if it
+ *    doesn't fit (or is empty), like strftime().
+ */
+
+unsigned
+TMFMT_renderArr(TMFMT *self, char *bufArr, size_t buf_sz, const time_t *whenArr, unsigned nWhens);
+/***********************************************
+ * Render each of whenArr[nWhens] into consecutive
+ * buffers of buf_sz bytes, starting at bufArr.
+ *
+ * returns - how many were rendered successfully.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
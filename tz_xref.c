@@ -1,5 +1,12 @@
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <strings.h>
 
+#include "ez_libpthread.h"
 #include "tz_xref.h"
+#include "util.h"
 /***************************************************
  * Array of these structs provides the mapping between
  * Microsoft TZID or "TZID display name" to a POSIX
@@ -299,3 +306,114 @@ struct tz_xref Ms2Posix[]= {
    /*--- >>> LOOK <<< Add other members here ---*/
    { /* Terminating member */ }
 };
+
+/***************************************************
+ * Case-insensitive hash index over Ms2Posix[], built
+ * the first time it is needed. Slots hold the index
+ * of the entry + 1, so zero means empty.
+ */
+#define XREF_HASH_SZ 1024
+static unsigned short XrefHash[XREF_HASH_SZ];
+static unsigned short XrefLen[XREF_HASH_SZ/2];
+static unsigned char XrefOff[XREF_HASH_SZ/2];
+static pthread_once_t XrefHash_once= PTHREAD_ONCE_INIT;
+
+/* The TZIF for each indexed entry, once it has been looked up */
+static const TZIF *_Atomic XrefZone[XREF_HASH_SZ/2];
+
+static unsigned
+xrefHash(const char *key, size_t len)
+/***************************************************
+ * FNV-1a hash of the case-folded key.
+ */
+{
+   unsigned h= 2166136261u;
+   size_t i;
+   for(i= 0; i < len; ++i) {
+      h ^= (unsigned char)tolower((unsigned char)key[i]);
+      h *= 16777619u;
+   }
+   return h % XREF_HASH_SZ;
+}
+
+static void
+XrefHash_init(void)
+/***************************************************
+ * Index every member of Ms2Posix[], complaining
+ * about any which can never be found.
+ */
+{
+   unsigned i;
+   for(i= 0; Ms2Posix[i].ms; ++i) {
+
+      if(i >= XREF_HASH_SZ/2) {
+         eprintf("ERROR: XREF_HASH_SZ is too small for Ms2Posix[]");
+         break;
+      }
+
+      /* The key is the TZID, without the quotes or the colon */
+      const char *ms= Ms2Posix[i].ms;
+      size_t len= strlen(ms);
+      if('"' == *ms) {
+         ++ms;
+         len -= 2;
+         XrefOff[i]= 1;
+      } else {
+         --len;
+      }
+      XrefLen[i]= len;
+
+      unsigned h;
+      for(h= xrefHash(ms, len); XrefHash[h]; h= (h + 1) % XREF_HASH_SZ) {
+         unsigned j= XrefHash[h] - 1;
+         if(XrefLen[j] == len && !strncasecmp(Ms2Posix[j].ms + XrefOff[j], ms, len))
+            break;
+      }
+
+      if(XrefHash[h]) {
+         eprintf("ERROR: Ms2Posix[] has \"%s\" more than once", Ms2Posix[i].ms);
+         continue;
+      }
+
+      XrefHash[h]= i + 1;
+   }
+}
+
+const struct tz_xref*
+tz_xref_find(const char *tzid, size_t len)
+/***************************************************
+ * Find the Ms2Posix[] entry for a TZID.
+ */
+{
+   ez_pthread_once(&XrefHash_once, XrefHash_init);
+
+   unsigned h;
+   for(h= xrefHash(tzid, len); XrefHash[h]; h= (h + 1) % XREF_HASH_SZ) {
+      unsigned j= XrefHash[h] - 1;
+      if(XrefLen[j] == len && !strncasecmp(Ms2Posix[j].ms + XrefOff[j], tzid, len))
+         return Ms2Posix + j;
+   }
+
+   return NULL;
+}
+
+const TZIF*
+tz_xref_zone(const struct tz_xref *xref)
+/***************************************************
+ * Get the TZIF for an entry's POSIX zone.
+ */
+{
+   size_t ndx= xref - Ms2Posix;
+   if(ndx >= XREF_HASH_SZ/2)
+      return TZIF_get(xref->posix);
+
+   const TZIF *rtn= atomic_load_explicit(XrefZone + ndx, memory_order_acquire);
+   if(rtn)
+      return rtn;
+
+   /* Threads racing here all get the same zone from TZIF_get() */
+   if((rtn= TZIF_get(xref->posix)))
+      atomic_store_explicit(XrefZone + ndx, rtn, memory_order_release);
+
+   return rtn;
+}
@@ -1,6 +1,10 @@
 #ifndef TZ_XREF_H
 #define TZ_XREF_H
 
+#include <stddef.h>
+
+#include "tzif.h"
+
 /* Use this to cross-reference timezones between Windows & POSIX */
 
 struct tz_xref {
@@ -10,5 +14,36 @@ struct tz_xref {
 
 extern struct tz_xref Ms2Posix[];
 
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+const struct tz_xref*
+tz_xref_find(const char *tzid, size_t len);
+/***********************************************
+ * Find the Ms2Posix[] entry for the len bytes of
+ * a TZID parameter value at tzid, without quotes.
+ * Case is ignored.
+ *
+ * returns - the entry, or NULL if there is none.
+ */
+
+const TZIF*
+tz_xref_zone(const struct tz_xref *xref);
+/***********************************************
+ * Get the TZIF for the POSIX zone of an entry
+ * returned by tz_xref_find(). The zone is looked
+ * up with TZIF_get() the first time, and kept in
+ * a slot for the entry, which later calls read
+ * without taking any lock.
+ *
+ * returns - the zone, or NULL for failure.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
 
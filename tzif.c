@@ -0,0 +1,890 @@
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ez_libc.h"
+#include "ez_libpthread.h"
+#include "ptrvec.h"
+#include "tzif.h"
+#include "util.h"
+
+/*===========================================================================*/
+/*=================== Forward declarations ==================================*/
+/*===========================================================================*/
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d);
+static int parseTZif(TZIF *self, const unsigned char *buf, size_t buf_sz);
+static int parseRule(struct tzif_rule *rule, const char *str);
+static int compileVTIMEZONE(TZIF *self, const char *def);
+static void lookup(const TZIF *self, int64_t when, struct tzif_lt *rtnBuf);
+
+/*===========================================================================*/
+/*=================== static data ===========================================*/
+/*===========================================================================*/
+
+/* Zones loaded so far, shared by everyone */
+static pthread_mutex_t Cache_mtx= PTHREAD_MUTEX_INITIALIZER;
+static PTRVEC Cache_vec;
+
+/* Zones compiled from VTIMEZONE components, by hash of the definition.
+ * Definitions which would not compile are kept too, so they are not
+ * parsed again; at most TZIF_VTZ_MAX definitions of either kind.
+ */
+#define VTZ_HASH_SZ 256
+static TZIF *VtzHash[VTZ_HASH_SZ];
+static unsigned VtzCount;
+static int VtzFull_warned;
+
+#define SECS_PER_DAY 86400
+
+/*===========================================================================*/
+/*=================== TZIF methods ==========================================*/
+/*===========================================================================*/
+
+TZIF*
+TZIF_constructor(TZIF *self, const char *name)
+/***********************************************
+ * Construct a TZIF, loading the zoneinfo file
+ * for name.
+ */
+{
+   TZIF *rtn= NULL;
+   unsigned char *buf= NULL;
+   int fd= -1;
+
+   if(!self) return NULL;
+   memset(self, 0, sizeof(*self));
+
+   /* Don't let a name wander out of the zoneinfo directory */
+   if(!*name || '/' == *name || strstr(name, "..")) {
+      eprintf("ERROR: invalid timezone name \"%s\"", name);
+      goto abort;
+   }
+
+   if(!(self->name= strdup(name))) {
+      sys_eprintf("ERROR: strdup() failed");
+      goto abort;
+   }
+
+   const char *dir= getenv("TZDIR");
+   if(!dir || !*dir)
+      dir= "/usr/share/zoneinfo";
+
+   char path[PATH_MAX];
+   snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+   fd= open(path, O_RDONLY);
+   if(-1 == fd) {
+      sys_eprintf("ERROR: open(\"%s\") failed", path);
+      goto abort;
+   }
+
+   struct stat st;
+   if(-1 == fstat(fd, &st)) {
+      sys_eprintf("ERROR: fstat(\"%s\") failed", path);
+      goto abort;
+   }
+
+   if(!(buf= malloc(st.st_size + 1))) {
+      sys_eprintf("ERROR: malloc(%zu) failed", (size_t)st.st_size + 1);
+      goto abort;
+   }
+
+   size_t len= 0;
+   while(len < (size_t)st.st_size) {
+      ssize_t rc= read(fd, buf + len, st.st_size - len);
+      if(-1 == rc) {
+         if(EINTR == errno) continue;
+         sys_eprintf("ERROR: read(\"%s\") failed", path);
+         goto abort;
+      }
+      if(!rc) break;
+      len += rc;
+   }
+
+   if(parseTZif(self, buf, len)) {
+      eprintf("ERROR: \"%s\" is not a valid TZif file", path);
+      goto abort;
+   }
+
+   rtn= self;
+abort:
+   if(-1 != fd) ez_close(fd);
+   if(buf) free(buf);
+   return rtn;
+}
+
+void*
+TZIF_destructor(TZIF *self)
+/***********************************************
+ * Destruct a TZIF.
+ */
+{
+   if(self->name) free(self->name);
+   if(self->transArr) free(self->transArr);
+   if(self->trans_typeArr) free(self->trans_typeArr);
+   if(self->typeArr) free(self->typeArr);
+   if(self->abbrs) free(self->abbrs);
+   if(self->vtz_def) free(self->vtz_def);
+   return self;
+}
+
+const TZIF*
+TZIF_get(const char *name)
+/***********************************************
+ * Get the TZIF for name, loading it the first
+ * time it is asked for.
+ */
+{
+   TZIF *rtn= NULL,
+        *tz;
+   unsigned i;
+
+   ez_pthread_mutex_lock(&Cache_mtx);
+
+   /* Not PTRVEC_sinit(), which would empty the cache each time */
+   if(!Cache_vec.ptrArr && !PTRVEC_constructor(&Cache_vec, 16))
+      goto abort;
+
+   PTRVEC_loopFwd(&Cache_vec, i, tz) {
+      if(!strcmp(tz->name, name)) {
+         rtn= tz;
+         goto abort;
+      }
+   }
+
+   TZIF_create(tz, name);
+   if(!tz)
+      goto abort;
+
+   PTRVEC_addTail(&Cache_vec, tz);
+   rtn= tz;
+
+abort:
+   ez_pthread_mutex_unlock(&Cache_mtx);
+   return rtn;
+}
+
+TZIF*
+TZIF_getVTIMEZONE(const char *def)
+/***********************************************
+ * Get the TZIF for a VTIMEZONE component, compiling
+ * it the first time this exact definition is seen.
+ */
+{
+   TZIF *rtn= NULL,
+        *tz;
+
+   /* FNV-1a, over the TZID and everything else */
+   uint64_t hash= 14695981039346656037u;
+   const char *p;
+   for(p= def; *p; ++p) {
+      hash ^= (unsigned char)*p;
+      hash *= 1099511628211u;
+   }
+
+   TZIF **bucket= VtzHash + hash % VTZ_HASH_SZ;
+
+   ez_pthread_mutex_lock(&Cache_mtx);
+
+   for(tz= *bucket; tz; tz= tz->vtz_next) {
+      if(tz->vtz_hash == hash && !strcmp(tz->vtz_def, def)) {
+         if(!tz->vtz_is_bad)
+            rtn= tz;
+         goto abort;
+      }
+   }
+
+   if(VtzCount >= TZIF_VTZ_MAX) {
+      if(!VtzFull_warned) {
+         VtzFull_warned= 1;
+         eprintf("WARNING: %u VTIMEZONE definitions seen; using Ms2Posix[] for any more", TZIF_VTZ_MAX);
+      }
+      goto abort;
+   }
+
+   if(!(tz= calloc(1, sizeof(*tz)))) {
+      sys_eprintf("ERROR: calloc() failed");
+      goto abort;
+   }
+
+   if(compileVTIMEZONE(tz, def)) {
+
+      /* Keep only the definition, to know it next time */
+      char *vtz_def= tz->vtz_def;
+      tz->vtz_def= NULL;
+      TZIF_destructor(tz);
+      memset(tz, 0, sizeof(*tz));
+
+      if(!vtz_def && !(vtz_def= strdup(def))) {
+         sys_eprintf("ERROR: strdup() failed");
+         free(tz);
+         goto abort;
+      }
+      tz->vtz_def= vtz_def;
+      tz->vtz_is_bad= 1;
+   }
+
+   tz->vtz_hash= hash;
+   tz->vtz_next= *bucket;
+   *bucket= tz;
+   ++VtzCount;
+
+   if(!tz->vtz_is_bad)
+      rtn= tz;
+
+abort:
+   ez_pthread_mutex_unlock(&Cache_mtx);
+   return rtn;
+}
+
+time_t
+TZIF_mktime(const TZIF *self, const struct tm *tm)
+/***********************************************
+ * Convert the local date + time in tm to UTC.
+ */
+{
+   int64_t local= (int64_t)days_from_civil(tm->tm_year + 1900LL, tm->tm_mon + 1, tm->tm_mday) * SECS_PER_DAY
+                  + tm->tm_hour * 3600 + tm->tm_min * 60 + tm->tm_sec;
+
+   /* Any change of offset near this time is between these two */
+   struct tzif_lt before, after, lt;
+   lookup(self, local - SECS_PER_DAY, &before);
+   lookup(self, local + SECS_PER_DAY, &after);
+
+   int64_t t_before= local - before.utoff,
+           t_after= local - after.utoff;
+
+   /* See which of the offsets really applies at the resulting time */
+   lookup(self, t_before, &lt);
+   int is_before= lt.utoff == before.utoff;
+   lookup(self, t_after, &lt);
+   int is_after= lt.utoff == after.utoff;
+
+   if(is_before && is_after)
+      return t_before < t_after ? t_before : t_after;
+
+   if(is_after)
+      return t_after;
+
+   /* Either only the old offset works, or this time was skipped */
+   return t_before;
+}
+
+struct tm*
+TZIF_localtime(const TZIF *self, time_t when, struct tm *rtnBuf)
+/***********************************************
+ * Convert when to local time in this zone.
+ */
+{
+   struct tzif_lt lt;
+   lookup(self, when, &lt);
+
+   time_t local= when + lt.utoff;
+   if(!gmtime_r(&local, rtnBuf))
+      return NULL;
+
+   rtnBuf->tm_isdst= lt.isdst;
+   rtnBuf->tm_gmtoff= lt.utoff;
+   rtnBuf->tm_zone= lt.abbr;
+   return rtnBuf;
+}
+
+/*===========================================================================*/
+/*===================== supporting functions ================================*/
+/*===========================================================================*/
+
+static int64_t
+days_from_civil(int64_t y, unsigned m, unsigned d)
+/******************************************************
+ * Days since 1970-01-01 of a proleptic Gregorian date.
+ */
+{
+   y -= m <= 2;
+   int64_t era= (y >= 0 ? y : y - 399) / 400;
+   unsigned yoe= (unsigned)(y - era * 400),
+            doy= (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1,
+            doe= yoe * 365 + yoe / 4 - yoe / 100 + doy;
+   return era * 146097 + (int64_t)doe - 719468;
+}
+
+static int
+is_leap(int64_t y)
+/******************************************************
+ * Nonzero if y is a Gregorian leap year.
+ */
+{
+   return !(y % 4) && ((y % 100) || !(y % 400));
+}
+
+static int64_t
+year_of(int64_t when)
+/******************************************************
+ * Gregorian year of a time in seconds since the epoch.
+ */
+{
+   int64_t z= (when >= 0 ? when : when - (SECS_PER_DAY - 1)) / SECS_PER_DAY + 719468,
+           era= (z >= 0 ? z : z - 146096) / 146097;
+   unsigned doe= (unsigned)(z - era * 146097),
+            yoe= (doe - doe/1460 + doe/36524 - doe/146096) / 365,
+            doy= doe - (365*yoe + yoe/4 - yoe/100),
+            mp= (5*doy + 2)/153;
+   return (int64_t)yoe + era * 400 + (mp >= 10);
+}
+
+static int64_t
+rule_date(const struct tzif_date *date, int64_t year)
+/******************************************************
+ * Local time, in seconds since the epoch, at which
+ * date happens in year.
+ */
+{
+   int64_t jan1= days_from_civil(year, 1, 1),
+           day;
+
+   switch(date->kind) {
+
+      case TZIF_JULIAN1:
+         day= jan1 + date->n - 1 + (is_leap(year) && date->n >= 60);
+         break;
+
+      case TZIF_JULIAN0:
+         day= jan1 + date->n;
+         break;
+
+      default: {
+         static const unsigned char mdays[]= {31,28,31,30,31,30,31,31,30,31,30,31};
+         int64_t first= days_from_civil(year, date->m, 1);
+
+         /* 1970-01-01 was a Thursday */
+         int dow1= (int)(((first + 4) % 7 + 7) % 7);
+         int mday= 1 + (date->d - dow1 + 7) % 7 + (date->w - 1) * 7,
+             ndays= mdays[date->m - 1] + (2 == date->m && is_leap(year));
+
+         /* Week 5 means the last one */
+         while(mday > ndays)
+            mday -= 7;
+
+         day= first + mday - 1;
+      } break;
+   }
+
+   return day * SECS_PER_DAY + date->secs;
+}
+
+static void
+rule_lookup(const struct tzif_rule *rule, int64_t when, struct tzif_lt *rtnBuf)
+/******************************************************
+ * Find the local time type a POSIX TZ rule gives at
+ * when.
+ */
+{
+   int is_dst= 0;
+
+   if(rule->has_dst) {
+
+      int64_t year= year_of(when + rule->std_off),
+              start= rule_date(&rule->start, year) - rule->std_off,
+              end= rule_date(&rule->end, year) - rule->dst_off;
+
+      is_dst= start < end ?
+         when >= start && when < end :  /* Northern hemisphere */
+         !(when >= end && when < start); /* Southern hemisphere */
+   }
+
+   rtnBuf->utoff= is_dst ? rule->dst_off : rule->std_off;
+   rtnBuf->isdst= is_dst;
+   rtnBuf->abbr= is_dst ? rule->dst_abbr : rule->std_abbr;
+}
+
+static void
+lookup(const TZIF *self, int64_t when, struct tzif_lt *rtnBuf)
+/******************************************************
+ * Find the local time type in effect at when.
+ */
+{
+   const struct tzif_type *type;
+
+   if(self->has_rule && (!self->nTrans || when >= self->transArr[self->nTrans - 1])) {
+      rule_lookup(&self->rule, when, rtnBuf);
+      return;
+   }
+
+   if(!self->nTrans || when < self->transArr[0]) {
+      type= self->typeArr;
+
+   } else {
+
+      /* Last transition at or before when */
+      unsigned lo= 0,
+               hi= self->nTrans;
+      while(hi - lo > 1) {
+         unsigned mid= lo + (hi - lo) / 2;
+         if(self->transArr[mid] <= when)
+            lo= mid;
+         else
+            hi= mid;
+      }
+
+      type= self->typeArr + self->trans_typeArr[lo];
+   }
+
+   rtnBuf->utoff= type->utoff;
+   rtnBuf->isdst= type->isdst;
+   rtnBuf->abbr= self->abbrs + type->abbr_ndx;
+}
+
+static uint32_t
+be32(const unsigned char *p)
+{
+   return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static uint64_t
+be64(const unsigned char *p)
+{
+   return (uint64_t)be32(p) << 32 | be32(p + 4);
+}
+
+static int
+parseTZif(TZIF *self, const unsigned char *buf, size_t buf_sz)
+/******************************************************
+ * Parse the contents of a TZif file into self.
+ * Returns 0 for success, -1 for error.
+ */
+{
+   enum { HDR_SZ= 44 };
+   const unsigned char *p= buf,
+                       *end= buf + buf_sz;
+
+   if(buf_sz < HDR_SZ || memcmp(p, "TZif", 4))
+      return -1;
+
+   int version= p[4];
+
+   /* Counts from a header */
+   uint32_t isutcnt, isstdcnt, leapcnt, timecnt, typecnt, charcnt;
+#define COUNTS(h) \
+   isutcnt= be32(h+20); isstdcnt= be32(h+24); leapcnt= be32(h+28); \
+   timecnt= be32(h+32); typecnt= be32(h+36); charcnt= be32(h+40)
+
+   COUNTS(p);
+   unsigned time_sz= 4;
+
+   /* Version 2 and later repeat everything with 64 bit times; use that */
+   if(version) {
+      size_t v1_sz= timecnt*5 + typecnt*6 + charcnt + leapcnt*8 + isstdcnt + isutcnt;
+      if(v1_sz > (size_t)(end - p) - HDR_SZ)
+         return -1;
+      p += HDR_SZ + v1_sz;
+
+      if((size_t)(end - p) < HDR_SZ || memcmp(p, "TZif", 4))
+         return -1;
+      COUNTS(p);
+      time_sz= 8;
+   }
+#undef COUNTS
+
+   p += HDR_SZ;
+
+   if(!typecnt || typecnt > 256 || !charcnt ||
+      (size_t)(end - p) < timecnt*(time_sz+1) + typecnt*6 + charcnt + leapcnt*(time_sz+4) + isstdcnt + isutcnt)
+      return -1;
+
+   self->nTrans= timecnt;
+   self->nTypes= typecnt;
+   self->abbrs_sz= charcnt;
+
+   if(!(self->transArr= malloc((timecnt ? timecnt : 1) * sizeof(*self->transArr))) ||
+      !(self->trans_typeArr= malloc(timecnt ? timecnt : 1)) ||
+      !(self->typeArr= malloc(typecnt * sizeof(*self->typeArr))) ||
+      !(self->abbrs= malloc(charcnt + 1)))
+   {
+      sys_eprintf("ERROR: malloc() failed");
+      return -1;
+   }
+
+   unsigned i;
+   for(i= 0; i < timecnt; ++i, p += time_sz)
+      self->transArr[i]= 8 == time_sz ? (int64_t)be64(p) : (int32_t)be32(p);
+
+   for(i= 0; i < timecnt; ++i, ++p) {
+      if(*p >= typecnt)
+         return -1;
+      self->trans_typeArr[i]= *p;
+   }
+
+   for(i= 0; i < typecnt; ++i, p += 6) {
+      self->typeArr[i].utoff= (int32_t)be32(p);
+      self->typeArr[i].isdst= p[4];
+      self->typeArr[i].abbr_ndx= p[5];
+      if(p[5] >= charcnt)
+         return -1;
+   }
+
+   memcpy(self->abbrs, p, charcnt);
+   self->abbrs[charcnt]= '\0';
+   p += charcnt;
+
+   /* Leap seconds and the standard/wall & UT/local indicators don't matter to us */
+   p += leapcnt*(time_sz+4) + isstdcnt + isutcnt;
+
+   /* The footer is a POSIX TZ rule between newlines */
+   if(version && p < end && '\n' == *p) {
+      const unsigned char *nl= memchr(p + 1, '\n', end - p - 1);
+      if(nl && nl > p + 1) {
+         char rule[128];
+         size_t len= nl - p - 1;
+         if(len < sizeof(rule)) {
+            memcpy(rule, p + 1, len);
+            rule[len]= '\0';
+            self->has_rule= !parseRule(&self->rule, rule);
+         }
+      }
+   }
+
+   return 0;
+}
+
+static const char*
+parseAbbr(char *buf, size_t buf_sz, const char *str)
+/******************************************************
+ * Parse a timezone abbreviation in a POSIX TZ rule.
+ * Returns what follows it, or NULL for error.
+ */
+{
+   const char *end;
+
+   if('<' == *str) {
+      ++str;
+      end= strchr(str, '>');
+      if(!end) return NULL;
+   } else {
+      for(end= str; isalpha((unsigned char)*end); ++end);
+   }
+
+   size_t len= end - str;
+   if(len < 3 || len >= buf_sz)
+      return NULL;
+
+   memcpy(buf, str, len);
+   buf[len]= '\0';
+
+   return '>' == *end ? end + 1 : end;
+}
+
+static const char*
+parseSecs(int32_t *rtnBuf, const char *str)
+/******************************************************
+ * Parse [+-]hh[:mm[:ss]] in a POSIX TZ rule.
+ * Returns what follows it, or NULL for error.
+ */
+{
+   int sign= 1;
+   if('+' == *str || '-' == *str)
+      sign= '-' == *str++ ? -1 : 1;
+
+   if(!isdigit((unsigned char)*str))
+      return NULL;
+
+   char *nxt;
+   long secs= strtol(str, &nxt, 10) * 3600;
+   if(':' == *nxt) {
+      secs += strtol(nxt + 1, &nxt, 10) * 60;
+      if(':' == *nxt)
+         secs += strtol(nxt + 1, &nxt, 10);
+   }
+
+   *rtnBuf= sign * secs;
+   return nxt;
+}
+
+static const char*
+parseDate(struct tzif_date *date, const char *str)
+/******************************************************
+ * Parse ,date[/time] in a POSIX TZ rule.
+ * Returns what follows it, or NULL for error.
+ */
+{
+   char *nxt;
+
+   if(',' != *str++)
+      return NULL;
+
+   if('J' == *str) {
+      date->kind= TZIF_JULIAN1;
+      date->n= strtol(str + 1, &nxt, 10);
+      if(date->n < 1 || date->n > 365) return NULL;
+
+   } else if('M' == *str) {
+      date->kind= TZIF_MWD;
+      date->m= strtol(str + 1, &nxt, 10);
+      if('.' != *nxt) return NULL;
+      date->w= strtol(nxt + 1, &nxt, 10);
+      if('.' != *nxt) return NULL;
+      date->d= strtol(nxt + 1, &nxt, 10);
+      if(date->m < 1 || date->m > 12 || date->w < 1 || date->w > 5 || date->d < 0 || date->d > 6)
+         return NULL;
+
+   } else if(isdigit((unsigned char)*str)) {
+      date->kind= TZIF_JULIAN0;
+      date->n= strtol(str, &nxt, 10);
+      if(date->n > 365) return NULL;
+
+   } else
+      return NULL;
+
+   /* Default time of day is 02:00:00 */
+   date->secs= 7200;
+   if('/' == *nxt)
+      return parseSecs(&date->secs, nxt + 1);
+
+   return nxt;
+}
+
+static int
+parseRule(struct tzif_rule *rule, const char *str)
+/******************************************************
+ * Parse a POSIX TZ rule, e.g. "EST5EDT,M3.2.0,M11.1.0".
+ * Returns 0 for success, -1 for error.
+ */
+{
+   memset(rule, 0, sizeof(*rule));
+
+   /* POSIX offsets are west of UTC */
+   if(!(str= parseAbbr(rule->std_abbr, sizeof(rule->std_abbr), str)) ||
+      !(str= parseSecs(&rule->std_off, str)))
+      return -1;
+   rule->std_off= -rule->std_off;
+
+   if(!*str)
+      return 0;
+
+   if(!(str= parseAbbr(rule->dst_abbr, sizeof(rule->dst_abbr), str)))
+      return -1;
+   rule->has_dst= 1;
+
+   /* Daylight saving time defaults to an hour ahead */
+   rule->dst_off= rule->std_off + 3600;
+   if(*str && ',' != *str) {
+      if(!(str= parseSecs(&rule->dst_off, str)))
+         return -1;
+      rule->dst_off= -rule->dst_off;
+   }
+
+   /* With no dates, US rules are the customary default */
+   if(!*str)
+      str= ",M3.2.0,M11.1.0";
+
+   if(!(str= parseDate(&rule->start, str)) ||
+      !(str= parseDate(&rule->end, str)) ||
+      *str)
+      return -1;
+
+   return 0;
+}
+
+/* What we keep of a STANDARD or DAYLIGHT component */
+struct vtz_comp {
+   int is_set;
+
+   /* DTSTART as local seconds since the epoch, for picking the latest */
+   int64_t dtstart;
+
+   int32_t offset_to;
+   char tzname[16];
+
+   /* RRULE:FREQ=YEARLY;BYMONTH=m;BYDAY=nDD */
+   int is_yearly,
+       is_unusable,
+       month,
+       nth,
+       wday;
+};
+
+static int
+parseOffset(int32_t *rtnBuf, const char *str)
+/******************************************************
+ * Parse a UTC offset, [+-]hhmm[ss].
+ * Returns 0 for success, -1 for error.
+ */
+{
+   int sign;
+   if('+' == *str) sign= 1;
+   else if('-' == *str) sign= -1;
+   else return -1;
+
+   unsigned hh, mm, ss= 0;
+   size_t len= strlen(++str);
+   if((4 != len && 6 != len) || strspn(str, "0123456789") != len)
+      return -1;
+
+   sscanf(str, "%2u%2u%2u", &hh, &mm, &ss);
+   *rtnBuf= sign * (int32_t)(hh*3600 + mm*60 + ss);
+   return 0;
+}
+
+static void
+parseRRULE(struct vtz_comp *comp, char *str)
+/******************************************************
+ * Parse the parts of an RRULE we can make a POSIX
+ * rule out of.
+ */
+{
+   static const char *const wdays[]= {"SU","MO","TU","WE","TH","FR","SA"};
+   char *part,
+        *save;
+
+   for(part= strtok_r(str, ";", &save); part; part= strtok_r(NULL, ";", &save)) {
+
+      if(!strcmp(part, "FREQ=YEARLY")) {
+         comp->is_yearly= 1;
+
+      } else if(!strcmp(part, "INTERVAL=1") || !strncmp(part, "WKST=", 5)) {
+         /* Makes no difference */
+
+      } else if(1 == sscanf(part, "BYMONTH=%d", &comp->month)) {
+         if(comp->month < 1 || comp->month > 12)
+            comp->is_unusable= 1;
+
+      } else if(!strncmp(part, "BYDAY=", 6)) {
+         char *wday;
+         comp->nth= strtol(part + 6, &wday, 10);
+         for(comp->wday= 0; comp->wday < 7 && strcmp(wday, wdays[comp->wday]); ++comp->wday);
+         if(7 == comp->wday || !comp->nth || comp->nth < -1 || comp->nth > 5)
+            comp->is_unusable= 1;
+
+      } else {
+         /* UNTIL, BYMONTHDAY, etc. aren't something a POSIX rule can say */
+         comp->is_unusable= 1;
+      }
+   }
+}
+
+static int
+compileDate(struct tzif_date *date, const struct vtz_comp *comp)
+/******************************************************
+ * Turn the recurrence of comp into a POSIX rule date.
+ * Returns 0 for success, -1 for error.
+ */
+{
+   if(!comp->is_yearly || comp->is_unusable || !comp->month || !comp->nth)
+      return -1;
+
+   date->kind= TZIF_MWD;
+   date->m= comp->month;
+   date->w= -1 == comp->nth ? 5 : comp->nth;
+   date->d= comp->wday;
+
+   /* The transition happens at DTSTART's time of day */
+   date->secs= ((comp->dtstart % SECS_PER_DAY) + SECS_PER_DAY) % SECS_PER_DAY;
+   return 0;
+}
+
+static int
+compileVTIMEZONE(TZIF *self, const char *def)
+/******************************************************
+ * Compile a VTIMEZONE definition into self's rule.
+ * Returns 0 for success, -1 for error.
+ */
+{
+   struct vtz_comp std= {0},
+                   dst= {0},
+                   comp= {0};
+   int in_comp= 0,
+       is_dst= 0;
+
+   if(!(self->vtz_def= strdup(def))) {
+      sys_eprintf("ERROR: strdup() failed");
+      return -1;
+   }
+
+   const char *line= def;
+   while(*line) {
+
+      /* Work on a copy of the line we can scribble on */
+      const char *nl= strchr(line, '\n');
+      size_t len= nl ? (size_t)(nl - line) : strlen(line);
+      char buf[256];
+      snprintf(buf, sizeof(buf), "%.*s", (int)len, line);
+      line += len + (nl ? 1 : 0);
+
+      if(!in_comp) {
+
+         if(!strncmp(buf, "TZID:", 5)) {
+            char *tzid= buf + 5;
+            size_t tzid_len= strlen(tzid);
+            if('"' == *tzid && tzid_len > 1 && '"' == tzid[tzid_len-1]) {
+               tzid[tzid_len-1]= '\0';
+               ++tzid;
+            }
+            if(self->name) free(self->name);
+            if(!(self->name= strdup(tzid))) {
+               sys_eprintf("ERROR: strdup() failed");
+               return -1;
+            }
+
+         } else if(!strcmp(buf, "BEGIN:STANDARD") || !strcmp(buf, "BEGIN:DAYLIGHT")) {
+            in_comp= 1;
+            is_dst= 'D' == buf[6];
+            memset(&comp, 0, sizeof(comp));
+         }
+         continue;
+      }
+
+      if(!strncmp(buf, "END:", 4)) {
+         in_comp= 0;
+
+         /* Keep whichever came into effect last */
+         struct vtz_comp *keep= is_dst ? &dst : &std;
+         if(comp.is_set && (!keep->is_set || comp.dtstart >= keep->dtstart))
+            *keep= comp;
+
+      } else if(!strncmp(buf, "DTSTART:", 8)) {
+         unsigned y, mo, d, h, mi, sec;
+         if(6 != sscanf(buf + 8, "%4u%2u%2uT%2u%2u%2u", &y, &mo, &d, &h, &mi, &sec))
+            return -1;
+         comp.dtstart= days_from_civil(y, mo, d) * SECS_PER_DAY + h*3600 + mi*60 + sec;
+         comp.is_set= 1;
+
+      } else if(!strncmp(buf, "TZOFFSETTO:", 11)) {
+         if(parseOffset(&comp.offset_to, buf + 11))
+            return -1;
+
+      } else if(!strncmp(buf, "TZNAME", 6)) {
+         const char *name= strchr(buf, ':');
+         if(name)
+            snprintf(comp.tzname, sizeof(comp.tzname), "%s", name + 1);
+
+      } else if(!strncmp(buf, "RRULE:", 6)) {
+         parseRRULE(&comp, buf + 6);
+
+      } else if(!strncmp(buf, "RDATE", 5)) {
+         comp.is_unusable= 1;
+      }
+   }
+
+   if(!self->name || !std.is_set)
+      return -1;
+
+   struct tzif_rule *rule= &self->rule;
+   rule->std_off= std.offset_to;
+   memcpy(rule->std_abbr, std.tzname, sizeof(rule->std_abbr));
+
+   if(dst.is_set && dst.offset_to != std.offset_to) {
+
+      rule->has_dst= 1;
+      rule->dst_off= dst.offset_to;
+      memcpy(rule->dst_abbr, dst.tzname, sizeof(rule->dst_abbr));
+
+      if(compileDate(&rule->start, &dst) || compileDate(&rule->end, &std))
+         return -1;
+   }
+
+   self->has_rule= 1;
+   return 0;
+}
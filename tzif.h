@@ -0,0 +1,185 @@
+/************************************************************
+ * Class to convert between local time and UTC in a named
+ * timezone, without going through the TZ environment variable.
+ *
+ * The zone's TZif file (RFC 8536) is read from the zoneinfo
+ * directory ($TZDIR, or /usr/share/zoneinfo) once, and kept.
+ * Times past the last transition in the file follow the POSIX
+ * TZ rule in its footer.
+ *
+ * A zone may instead be compiled from a VTIMEZONE component
+ * (RFC 5545 section 3.6.5) carried in an invite, which yields
+ * just the rule.
+ */
+#ifndef TZIF_H
+#define TZIF_H
+
+#include <stdint.h>
+#include <time.h>
+
+/* Most VTIMEZONE definitions TZIF_getVTIMEZONE() will remember */
+#define TZIF_VTZ_MAX 1024
+
+/* A POSIX TZ rule, e.g. "EST5EDT,M3.2.0,M11.1.0" */
+struct tzif_rule {
+
+   /* Offsets are seconds east of UTC */
+   int32_t std_off,
+           dst_off;
+
+   char std_abbr[16],
+        dst_abbr[16];
+
+   /* Zero when the rule has no daylight saving time */
+   int has_dst;
+
+   /* When daylight saving time starts and ends */
+   struct tzif_date {
+      enum {
+         TZIF_JULIAN1,  /* Jn, 1 - 365, never counting Feb 29 */
+         TZIF_JULIAN0,  /* n, 0 - 365 */
+         TZIF_MWD       /* Mm.w.d */
+      } kind;
+      int n, m, w, d;
+
+      /* Local time of day, in seconds */
+      int32_t secs;
+   } start, end;
+};
+
+/* A local time type */
+struct tzif_type {
+   int32_t utoff;
+   unsigned char isdst,
+                 abbr_ndx;
+};
+
+/* What lookups find in effect at some time */
+struct tzif_lt {
+   int32_t utoff;
+   int isdst;
+   const char *abbr;
+};
+
+typedef struct _TZIF {
+
+   /* POSIX name, e.g. "America/Chicago", or the TZID of a VTIMEZONE */
+   char *name;
+
+   /* Transition times, and which type takes effect at each one */
+   int64_t *transArr;
+   unsigned char *trans_typeArr;
+   unsigned nTrans;
+
+   struct tzif_type *typeArr;
+   unsigned nTypes;
+
+   /* Time zone abbreviations, indexed by abbr_ndx */
+   char *abbrs;
+   unsigned abbrs_sz;
+
+   /* For times after the last transition */
+   struct tzif_rule rule;
+   int has_rule;
+
+   /* For zones compiled from a VTIMEZONE, its text and hash, and
+    * the next zone in the same hash bucket. A definition which
+    * would not compile is kept with vtz_is_bad set, and nothing else.
+    */
+   char *vtz_def;
+   uint64_t vtz_hash;
+   struct _TZIF *vtz_next;
+   int vtz_is_bad;
+
+} TZIF;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define TZIF_create(p, name) \
+  ((p)=(TZIF_constructor((p)=malloc(sizeof(TZIF)), name) ? (p) : ( p ? realloc(TZIF_destructor(p),0) : 0 )))
+TZIF*
+TZIF_constructor(TZIF *self, const char *name);
+/***********************************************
+ * Construct a TZIF, loading the zoneinfo file
+ * for name.
+ *
+ * returns - pointer to the object, or NULL for failure.
+ */
+
+void*
+TZIF_destructor(TZIF *self);
+/***********************************************
+ * Destruct a TZIF.
+ */
+
+#define TZIF_destroy(p) \
+  do {if(TZIF_destructor(p)) {free(p); p= NULL;}} while(0)
+
+const TZIF*
+TZIF_get(const char *name);
+/***********************************************
+ * Get the TZIF for name, loading it the first
+ * time it is asked for. Loaded zones are shared
+ * by all threads, and kept until the process exits.
+ * Each call takes a lock and searches the loaded
+ * zones, so keep the pointer rather than calling
+ * this for every conversion.
+ *
+ * returns - the zone, or NULL for failure.
+ */
+
+TZIF*
+TZIF_getVTIMEZONE(const char *def);
+/***********************************************
+ * Get the TZIF for a VTIMEZONE component, compiling
+ * it the first time this exact definition is seen.
+ * def is the unfolded lines between BEGIN:VTIMEZONE
+ * and END:VTIMEZONE, each ending with a newline.
+ * The zone's name is its TZID, without quotes. Like
+ * TZIF_get(), zones are shared and kept. So are
+ * definitions which cannot be used, so they are only
+ * parsed once. After TZIF_VTZ_MAX definitions, new
+ * ones are refused, which keeps a long batch run
+ * from growing without bound.
+ *
+ * Only the usual Outlook form is understood: a
+ * STANDARD and optionally a DAYLIGHT component,
+ * recurring yearly on the nth (or last) weekday of
+ * a month. Where there are several, the one with the
+ * latest DTSTART is used for every date, even those
+ * before its DTSTART; times from before the zone's
+ * rules last changed may be off by that change.
+ *
+ * returns - the zone, or NULL if it cannot be used.
+ */
+
+time_t
+TZIF_mktime(const TZIF *self, const struct tm *tm);
+/***********************************************
+ * Convert the local date + time in tm to UTC,
+ * like mktime() with tm_isdst of -1. A time which
+ * occurs twice when clocks fall back is taken to
+ * be the earlier one; a time skipped over when
+ * clocks spring forward is taken to be on the
+ * old offset.
+ *
+ * returns - UTC time.
+ */
+
+struct tm*
+TZIF_localtime(const TZIF *self, time_t when, struct tm *rtnBuf);
+/***********************************************
+ * Like localtime_r(), but for this zone. tm_zone
+ * points into the TZIF, so it stays valid.
+ *
+ * returns - rtnBuf, or NULL for failure.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
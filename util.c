@@ -41,6 +41,7 @@ Common utility routines needed by most c and c++ applications.
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <stddef.h>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -536,6 +537,184 @@ abort:
 #endif
 }
 
+static inline uint64_t
+load_le64 (const char *src)
+/***************************************************
+ * Load 8 bytes as a little-endian integer; compilers
+ * turn this into a single load where they can.
+ */
+{
+   const unsigned char *p= (const unsigned char*)src;
+   return (uint64_t)p[0]       | (uint64_t)p[1] << 8  | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+          (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+}
+
+static inline int
+is_8digits (uint64_t v)
+/***************************************************
+ * Nonzero if all 8 bytes of v are ASCII digits.
+ * Each byte must have 0x3 for its high nibble, and
+ * still have it after adding 6 to the low one.
+ */
+{
+   return !(((v & 0xF0F0F0F0F0F0F0F0ull) |
+            (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4))
+            ^ 0x3333333333333333ull);
+}
+
+static inline uint32_t
+parse_8digits (uint64_t v)
+/***************************************************
+ * Value of 8 ASCII digits, first one most significant.
+ */
+{
+   v= ((v & 0x0F0F0F0F0F0F0F0Full) * 2561) >> 8;
+   v= ((v & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+   return (uint32_t)(((v & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32);
+}
+
+const char*
+ical_strptime (const char *src, struct tm *tm)
+/***************************************************
+ * Parse an iCalendar DATE-TIME or DATE into tm.
+ */
+{
+   /* strnlen() keeps us from reading past a short string */
+   size_t len= strnlen(src, 15);
+   if(len < 8)
+      return NULL;
+
+   uint64_t date= load_le64(src);
+   if(!is_8digits(date))
+      return NULL;
+
+   uint32_t ymd= parse_8digits(date),
+            hms= 0;
+
+   const char *rtn= src + 8;
+
+   if('T' == src[8]) {
+
+      if(len < 15)
+         return NULL;
+
+      /* Take "DTHHMMSS" and make the 'T' a '0', so the value is D0HHMMSS */
+      uint64_t time= (load_le64(src + 7) & ~(0xFFull << 8)) | (uint64_t)'0' << 8;
+      if(!is_8digits(time))
+         return NULL;
+
+      hms= parse_8digits(time) % 1000000;
+      rtn= src + 15;
+   }
+
+   unsigned mon= ymd / 100 % 100,
+            mday= ymd % 100,
+            hour= hms / 10000,
+            min= hms / 100 % 100,
+            sec= hms % 100;
+
+   /* Check all the ranges at once; 60 is allowed for a leap second */
+   if((mon - 1 > 11) | (mday - 1 > 30) | (hour > 23) | (min > 59) | (sec > 60))
+      return NULL;
+
+   tm->tm_year= (int)(ymd / 10000) - 1900;
+   tm->tm_mon= mon - 1;
+   tm->tm_mday= mday;
+   tm->tm_hour= hour;
+   tm->tm_min= min;
+   tm->tm_sec= sec;
+
+   return rtn;
+}
+
+/* Parameters ical_params() knows, and where their values go */
+static const struct {
+   const char *name;
+   size_t len,
+          off;
+} IcalParamTbl[]= {
+#define ICAL_PARAM(name, field) {name, sizeof(name)-1, offsetof(struct ical_params, field)}
+   ICAL_PARAM("CN", cn),
+   ICAL_PARAM("CUTYPE", cutype),
+   ICAL_PARAM("PARTSTAT", partstat),
+   ICAL_PARAM("ROLE", role),
+   ICAL_PARAM("RSVP", rsvp),
+   ICAL_PARAM("SENT-BY", sent_by),
+   ICAL_PARAM("TZID", tzid),
+#undef ICAL_PARAM
+};
+
+const char*
+ical_params (const char *src, struct ical_params *rtn)
+/***************************************************
+ * Split up the parameters at src.
+ */
+{
+   memset(rtn, 0, sizeof(*rtn));
+
+   const char *p= src;
+   for(;;) {
+
+      if(';' == *p)
+         ++p;
+
+      /*--- Parameter name ---*/
+      const char *name= p;
+      p += strcspn(p, "=;:");
+      size_t name_len= p - name;
+
+      /*--- Value, which may be a comma separated list ---*/
+      const char *val= p;
+      if('=' == *p) {
+         val= ++p;
+         for(;;) {
+            if('"' == *p) {
+               if(!(p= strchr(p + 1, '"')))
+                  return NULL;
+               ++p;
+            } else {
+               p += strcspn(p, "\",;:");
+            }
+            if(',' != *p)
+               break;
+            ++p;
+         }
+      }
+      size_t val_len= p - val;
+
+      /* A single quoted value loses its quotes */
+      if(2 <= val_len && '"' == val[0] && '"' == val[val_len-1] && !memchr(val + 1, '"', val_len - 2)) {
+         ++val;
+         val_len -= 2;
+      }
+
+      unsigned i;
+      for(i= 0; i < sizeof(IcalParamTbl)/sizeof(IcalParamTbl[0]); ++i) {
+         if(IcalParamTbl[i].len == name_len && !strncasecmp(IcalParamTbl[i].name, name, name_len)) {
+            struct ical_slice *slice= (struct ical_slice*)((char*)rtn + IcalParamTbl[i].off);
+            slice->str= val;
+            slice->len= val_len;
+            break;
+         }
+      }
+
+      if(':' == *p)
+         return p + 1;
+
+      if(';' != *p)
+         return NULL;
+   }
+}
+
+int
+ical_slice_is (const struct ical_slice *slice, const char *str)
+/***************************************************
+ * Is slice str, ignoring case?
+ */
+{
+   return slice->str && !strncasecmp(slice->str, str, slice->len) && !str[slice->len];
+}
+
 int
 fd_setNONBLOCK (int fd)
 /***************************************************
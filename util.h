@@ -259,6 +259,59 @@ gmt_strftime (const time_t *pWhen, const char *fmt) \
  * string is passed to strftime().
  */
 
+const char*
+ical_strptime (const char *src, struct tm *tm);
+/***************************************************
+ * Parse an iCalendar (RFC 5545) DATE-TIME, i.e.
+ * YYYYMMDDTHHMMSS, or DATE, YYYYMMDD, at src into
+ * the date & time fields of tm; a DATE is midnight.
+ * Same as strptime(src, "%Y%m%dT%H%M%S", tm) for the
+ * fixed format, without the format interpretation
+ * or locale.
+ * Returns a pointer to what follows (e.g. 'Z' for
+ * UTC), or NULL if src isn't a valid DATE[-TIME].
+ */
+
+/* A piece of a line, not null terminated */
+struct ical_slice {
+   const char *str;
+   size_t len;
+};
+
+/* Property parameters (RFC 5545 section 3.2) found by ical_params() */
+struct ical_params {
+
+   /* Values of the parameters we know, without enclosing quotes;
+    * str is NULL for any which are absent.
+    */
+   struct ical_slice cn,
+                     cutype,
+                     partstat,
+                     role,
+                     rsvp,
+                     sent_by,
+                     tzid;
+};
+
+const char*
+ical_params (const char *src, struct ical_params *rtn);
+/***************************************************
+ * Split up the parameters of a content line in one
+ * pass, from src, which is just past the property
+ * name or one of the ';' separating parameters, to
+ * the ':' before the value. Values may be quoted, so
+ * ';', ':' and ',' inside quotes are not separators.
+ * Parameter names are matched without regard to case.
+ * Returns a pointer to the property value, or NULL
+ * if there is no ':' or a quote is not closed.
+ */
+
+int
+ical_slice_is (const struct ical_slice *slice, const char *str);
+/***************************************************
+ * Returns nonzero if slice is str, ignoring case.
+ */
+
 int
 fd_setNONBLOCK (int fd);
 /***************************************************
@@ -0,0 +1,856 @@
+/******************************************************************************
+ * Parser for Microsoft Outlook vcalendar attachments. All of the state for
+ * one input lives in a VCAL, so any number of them may be in use at once.
+ *
+ * If you need to add new MS Outlook <-> POSIX timezone mappings, place them
+ * in Ms2Posix[] in tz_xref.c. Local times are converted with the zone's
+ * zoneinfo file (see tzif.h), so TZ is never changed.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "atnd.h"
+#include "ez_libc.h"
+#include "ez_libpthread.h"
+#include "str.h"
+#include "tz_xref.h"
+#include "tzif.h"
+#include "util.h"
+#include "vcal.h"
+
+/* My preferred output format for date+time */
+#define STRFTIME_FMT "%H:%M %A %B %d, %Y %Z"
+
+/*===========================================================================*/
+/*=================== Forward declarations ==================================*/
+/*===========================================================================*/
+static int parseInput(VCAL *self);
+static void clearEvent(VCAL *self);
+static void PropHash_init(void);
+static const struct prop *findProp(const char *name, size_t name_len);
+static const TZIF *findVtz(VCAL *self, const struct ical_slice *tzid);
+static int renderTime(VCAL *self, STR *sb, const char *label, time_t when);
+static time_t vcal2utc(VCAL *self, const char *src);
+static void unescape(char *dst, const char *src);
+static const char *fetchPerson(VCAL *self, const char *src);
+
+/* Property handlers get the whole line, and what follows prop->follow */
+static int prop_BEGIN(VCAL *self, char *line, char *val);
+static int prop_END(VCAL *self, char *line, char *val);
+static int prop_DTSTART(VCAL *self, char *line, char *val);
+static int prop_DTEND(VCAL *self, char *line, char *val);
+static int prop_DTSTAMP(VCAL *self, char *line, char *val);
+static int prop_ORGANIZER(VCAL *self, char *line, char *val);
+static int prop_LOCATION(VCAL *self, char *line, char *val);
+static int prop_SUMMARY(VCAL *self, char *line, char *val);
+static int prop_DESCRIPTION(VCAL *self, char *line, char *val);
+static int prop_ATTENDEE(VCAL *self, char *line, char *val);
+
+/*===========================================================================*/
+/*=================== static data ===========================================*/
+/*===========================================================================*/
+
+/* The properties we pay attention to. To handle another one, add it here;
+ * everything else is skipped.
+ */
+#define PROP(name, follow) {#name, sizeof(#name)-1, follow, sizeof(follow)-1, prop_##name}
+static const struct prop {
+   const char *name;
+   unsigned name_len;
+
+   /* What must follow the name for the line to be ours */
+   const char *follow;
+   unsigned follow_len;
+
+   int (*parse_f)(VCAL *self, char *line, char *val);
+
+} PropTbl[]= {
+   PROP(BEGIN,       ":"),      // Start of a component
+   PROP(END,         ":"),      // End of a component
+   PROP(DTSTART,     ""),       // Start time of the event
+   PROP(DTEND,       ""),       // End time of the event
+   PROP(DTSTAMP,     ":"),      // When meeting was scheduled, UTC
+   PROP(ORGANIZER,   ";"),      // Event organizer
+   PROP(LOCATION,    ";"),      // Event location
+   PROP(SUMMARY,     ";"),      // Event summary
+   PROP(DESCRIPTION, ";"),      // Event description
+   PROP(ATTENDEE,    ";"),      // Attendees
+};
+#undef PROP
+
+/* Open addressed hash of PropTbl[] by name, holding index + 1 */
+#define PROP_HASH_SZ 32
+_Static_assert(sizeof(PropTbl)/sizeof(PropTbl[0]) < PROP_HASH_SZ/2, "PROP_HASH_SZ is too small");
+static unsigned char PropHash[PROP_HASH_SZ];
+static pthread_once_t PropHash_once= PTHREAD_ONCE_INIT;
+
+/*===========================================================================*/
+/*=================== VCAL methods ==========================================*/
+/*===========================================================================*/
+
+VCAL*
+VCAL_constructor(VCAL *self)
+/***********************************************
+ * Construct a VCAL.
+ */
+{
+   VCAL *rtn= NULL;
+
+   memset(self, 0, sizeof(*self));
+
+   if(!INBUF_constructor(&self->in) ||
+      !PTRVEC_constructor(&self->attendee_vec, 10) ||
+      !PTRVEC_constructor(&self->vtz_vec, 4) ||
+      !PTRVEC_constructor(&self->zone_vec, 4) ||
+      !STR_constructor(&self->vtz_sb, 1024) ||
+      !ARENA_constructor(&self->arena, 16384) ||
+      !STR_arena_constructor(&self->person_sb, STR_SSO_SZ, &self->arena) ||
+      !STR_constructor(&self->report_sb, 8192) ||
+      !TMFMT_constructor(&self->tmfmt, STRFTIME_FMT, NULL))
+      goto abort;
+
+   clearEvent(self);
+
+   rtn= self;
+abort:
+   return rtn;
+}
+
+void*
+VCAL_destructor(VCAL *self)
+/***********************************************
+ * Destruct a VCAL.
+ */
+{
+   if(PTRVEC_is_init(&self->attendee_vec)) {
+      VCAL_reset(self);
+      PTRVEC_destructor(&self->attendee_vec);
+   }
+   if(PTRVEC_is_init(&self->vtz_vec))
+      PTRVEC_destructor(&self->vtz_vec);
+   if(PTRVEC_is_init(&self->zone_vec)) {
+      TMFMT *fmt;
+      while((fmt= PTRVEC_remHead(&self->zone_vec)))
+         TMFMT_destroy(fmt);
+      PTRVEC_destructor(&self->zone_vec);
+   }
+   STR_destructor(&self->vtz_sb);
+   ARENA_destructor(&self->arena);
+   STR_destructor(&self->person_sb);
+   STR_destructor(&self->report_sb);
+   INBUF_destructor(&self->in);
+   TMFMT_destructor(&self->tmfmt);
+   return self;
+}
+
+void
+VCAL_reset(VCAL *self)
+/***********************************************
+ * Discard what we know about the last input,
+ * keeping the buffers for the next one.
+ */
+{
+   clearEvent(self);
+   PTRVEC_reset(&self->vtz_vec);
+   self->nEvents= 0;
+}
+
+void
+VCAL_setEventHandler(VCAL *self, int (*event_f)(VCAL *self, void *ctxt), void *ctxt)
+/***********************************************
+ * Have event_f called at the end of each VEVENT.
+ */
+{
+   self->event_f= event_f;
+   self->event_ctxt= ctxt;
+}
+
+int
+VCAL_addZone(VCAL *self, const char *name)
+/***********************************************
+ * Render times in the POSIX timezone name as well.
+ */
+{
+   const TZIF *tz= TZIF_get(name);
+   if(!tz)
+      return -1;
+
+   TMFMT *fmt;
+   if(!TMFMT_create(fmt, STRFTIME_FMT, tz))
+      return -1;
+
+   PTRVEC_addTail(&self->zone_vec, fmt);
+   return 0;
+}
+
+int
+VCAL_parseFile(VCAL *self, const char *path)
+/***********************************************
+ * Parse a vcalendar file, and make note of what
+ * we find.
+ */
+{
+   if(INBUF_open(&self->in, path))
+      return -1;
+
+   return parseInput(self);
+}
+
+int
+VCAL_parseBuf(VCAL *self, const char *buf, size_t buf_len)
+/***********************************************
+ * Same as VCAL_parseFile(), except the vcalendar
+ * input is in memory.
+ */
+{
+   if(INBUF_openBuf(&self->in, buf, buf_len))
+      return -1;
+
+   return parseInput(self);
+}
+
+int
+VCAL_parseRegion(VCAL *self, char *buf, size_t len)
+/***********************************************
+ * Same as VCAL_parseBuf(), but parse buf in place.
+ */
+{
+   if(INBUF_openRegion(&self->in, buf, len))
+      return -1;
+
+   return parseInput(self);
+}
+
+static void
+clearEvent(VCAL *self)
+/***********************************************
+ * Forget the event we have been collecting.
+ */
+{
+   /* The ATND objects, and any long person_sb buffer, live in the arena */
+   PTRVEC_reset(&self->attendee_vec);
+   ARENA_reset(&self->arena);
+   STR_recycle(&self->person_sb);
+
+   self->flags= 0;
+   self->summary= self->location= self->organizer= self->description= "";
+}
+
+static int
+parseInput(VCAL *self)
+/***********************************************
+ * Parse what was loaded into self->in.
+ * Returns 0 for success, -1 for error.
+ */
+{
+   int rtn= -1;
+   char *buf;
+
+   ez_pthread_once(&PropHash_once, PropHash_init);
+
+   /*===========================================================================*/
+   /*================ Grab one unfolded line at a time from source =============*/
+   /*===========================================================================*/
+   while ((buf= INBUF_getLine(&self->in, NULL))) {
+
+      /*---------------------------------------------------------------------------*/
+      /*-------------------- Process reassembled line -----------------------------*/
+      /*---------------------------------------------------------------------------*/
+
+      /* The property name ends at the first ';' or ':' */
+      size_t name_len= strcspn(buf, ";:");
+      if(!buf[name_len])
+         continue;
+
+      const struct prop *prop= findProp(buf, name_len);
+      if(!prop)
+         continue;
+
+      /* The rest of the line has to look the way we expect */
+      char *val= buf + name_len;
+      if(strncmp(val, prop->follow, prop->follow_len))
+         continue;
+
+      if((*prop->parse_f)(self, buf, val + prop->follow_len))
+         goto abort;
+   }
+
+   /* Successful */
+   rtn= 0;
+
+abort:
+   INBUF_close(&self->in);
+   return rtn;
+}
+
+int
+VCAL_render(VCAL *self, STR *sb)
+/***********************************************
+ * Append the report for what VCAL_parseFile() found
+ * to sb.
+ */
+{
+   int rtn= -1;
+   const VCAL_STYLE *st= &self->style;
+
+   char sched_str[64]= "";
+
+   /* If we render in other zones, the first one stands in for local time */
+   TMFMT *fmt= PTRVEC_numItems(&self->zone_vec) ? PTRVEC_first(&self->zone_vec) : &self->tmfmt;
+   if(self->flags & VCAL_SCHED_FLG)
+      TMFMT_render(fmt, sched_str, sizeof(sched_str), self->scheduled);
+
+   if(self->flags & VCAL_START_FLG)
+      if(renderTime(self, sb, "Event start", self->start))
+         goto abort;
+
+   if(self->flags & VCAL_END_FLG)
+      if(renderTime(self, sb, "  Event end", self->end))
+         goto abort;
+
+   if(self->flags & VCAL_SUMMARY_FLG)
+      if(-1 == STR_sprintf(sb, "\n%sSummary:%s %s%s\n\t%s\n"
+            , st->REV
+            , st->NORMAL
+            , self->flags & VCAL_SCHED_FLG ? "As of " : ""
+            , self->flags & VCAL_SCHED_FLG ? sched_str : ""
+            , self->summary
+            ))
+         goto abort;
+
+   if(self->flags & VCAL_LOCATION_FLG)
+      if(-1 == STR_sprintf(sb, "\n%sEvent location:%s %s\n"
+            , st->REV
+            , st->NORMAL
+            , self->location
+            ))
+         goto abort;
+
+   if(self->flags & VCAL_ORG_FLG)
+      if(-1 == STR_sprintf(sb, "\n%sEvent organizer:%s %s\n"
+            , st->REV
+            , st->NORMAL
+            , self->organizer
+            ))
+         goto abort;
+
+   if(self->flags & VCAL_DESC_FLG)
+      if(-1 == STR_sprintf(sb, "\n%sDescription:%s\n\t%s\n"
+            , st->REV
+            , st->NORMAL
+            , self->description
+            ))
+         goto abort;
+
+   /* Attendees */
+   if(ATND_sort(&self->attendee_vec, &self->arena))
+      goto abort;
+   if(PTRVEC_numItems(&self->attendee_vec)) {
+      if(-1 == STR_sprintf(sb, "\n%sAttendees:%s\n"
+            , st->REV
+            , st->NORMAL
+            ))
+         goto abort;
+      unsigned i;
+      ATND *atnd;
+      PTRVEC_loopFwd(&self->attendee_vec, i, atnd) {
+         if(ATND_render(atnd, sb, st->BOLD, st->NORMAL))
+            goto abort;
+      }
+   }
+
+   rtn= 0;
+abort:
+   return rtn;
+}
+
+int
+VCAL_report(VCAL *self, FILE *fh)
+/***********************************************
+ * Print the report for what VCAL_parseFile() found.
+ */
+{
+   STR *sb= &self->report_sb;
+   STR_reset(sb);
+
+   if(VCAL_render(self, sb))
+      return -1;
+
+   if(STR_len(sb))
+      ez_fwrite(STR_str(sb), STR_len(sb), 1, fh);
+
+   return 0;
+}
+
+/*===========================================================================*/
+/*===================== supporting functions ================================*/
+/*===========================================================================*/
+
+static unsigned
+propHash(const char *name, size_t name_len)
+/******************************************************
+ * Cheap hash of a property name.
+ */
+{
+   return (name_len * 7 + (unsigned char)name[0] * 3 + (unsigned char)name[name_len-1]) % PROP_HASH_SZ;
+}
+
+static void
+PropHash_init(void)
+/******************************************************
+ * Populate PropHash[] from PropTbl[].
+ */
+{
+   unsigned i;
+   for(i= 0; i < sizeof(PropTbl)/sizeof(PropTbl[0]); ++i) {
+      unsigned h= propHash(PropTbl[i].name, PropTbl[i].name_len);
+      while(PropHash[h])
+         h= (h + 1) % PROP_HASH_SZ;
+      PropHash[h]= i + 1;
+   }
+}
+
+static const struct prop*
+findProp(const char *name, size_t name_len)
+/******************************************************
+ * Look up a property by name.
+ * Returns the table entry, or NULL if we don't care about it.
+ */
+{
+   if(!name_len)
+      return NULL;
+
+   unsigned h;
+   for(h= propHash(name, name_len); PropHash[h]; h= (h + 1) % PROP_HASH_SZ) {
+      const struct prop *prop= PropTbl + PropHash[h] - 1;
+      if(prop->name_len == name_len && !memcmp(prop->name, name, name_len))
+         return prop;
+   }
+
+   return NULL;
+}
+
+static int
+prop_BEGIN(VCAL *self, char *line, char *val)
+/******************************************************
+ * Start of a component. Each VEVENT starts afresh. A
+ * VALARM has nothing for us, so it is skipped. A
+ * VTIMEZONE is swallowed whole here, and compiled so
+ * times using its TZID need not be looked up in
+ * Ms2Posix[].
+ */
+{
+   (void)line;
+
+   const char *buf;
+   size_t len;
+
+   if(!strcmp(val, "VEVENT")) {
+      clearEvent(self);
+      return 0;
+   }
+
+   if(!strcmp(val, "VALARM")) {
+      while((buf= INBUF_getLine(&self->in, NULL)) && strcmp(buf, "END:VALARM"));
+      return 0;
+   }
+
+   if(strcmp(val, "VTIMEZONE"))
+      return 0;
+
+   STR *sb= &self->vtz_sb;
+   STR_reset(sb);
+
+   while((buf= INBUF_getLine(&self->in, &len)) && strcmp(buf, "END:VTIMEZONE")) {
+      if(STR_append(sb, buf, len) || STR_putc(sb, '\n'))
+         return -1;
+   }
+
+   /* If we can't make sense of it, Ms2Posix[] is still there */
+   TZIF *tz= TZIF_getVTIMEZONE(STR_str(sb));
+   if(tz)
+      PTRVEC_addTail(&self->vtz_vec, tz);
+
+   return 0;
+}
+
+static int
+prop_END(VCAL *self, char *line, char *val)
+/******************************************************
+ * End of a component. At the end of a VEVENT, hand it
+ * to event_f, if there is one, and forget it.
+ */
+{
+   (void)line;
+
+   if(strcmp(val, "VEVENT"))
+      return 0;
+
+   ++self->nEvents;
+
+   if(!self->event_f)
+      return 0;
+
+   int rtn= (*self->event_f)(self, self->event_ctxt);
+   clearEvent(self);
+   return rtn;
+}
+
+static int
+prop_DTSTART(VCAL *self, char *line, char *val)
+/******************************************************
+ * Start time of the event.
+ */
+{
+   (void)line;
+#ifdef qqDEBUG
+eprintf(">>>>> line= \"%s\"", line);
+#endif
+   self->start= vcal2utc(self, val);
+   if(-1 == self->start)
+      return -1;
+
+   self->flags |= VCAL_START_FLG;
+   return 0;
+}
+
+static int
+prop_DTEND(VCAL *self, char *line, char *val)
+/******************************************************
+ * End time of the event.
+ */
+{
+   (void)line;
+
+   self->end= vcal2utc(self, val);
+   if(-1 == self->end)
+      return -1;
+
+   self->flags |= VCAL_END_FLG;
+   return 0;
+}
+
+static int
+prop_DTSTAMP(VCAL *self, char *line, char *val)
+/******************************************************
+ * When meeting was scheduled, UTC.
+ */
+{
+   (void)line;
+
+   const char *tm_str= val - 1; // NOTE: vcal2utc(self, ) needs the preceding colon
+
+   /* Convert 'struct tm' into time_t */
+   self->scheduled= vcal2utc(self, tm_str);
+   if(-1 == self->scheduled)
+      return -1;
+
+   self->flags |= VCAL_SCHED_FLG;
+   return 0;
+}
+
+static int
+prop_ORGANIZER(VCAL *self, char *line, char *val)
+/******************************************************
+ * Event organizer.
+ */
+{
+   (void)line;
+
+   /* Fetch formatted personal information */
+   const char *str= fetchPerson(self, val);
+
+   if(!str)
+      return -1;
+
+   str= skipspacec(str);
+   char *org= ARENA_strndup(&self->arena, str, strlen(str));
+   if(!org)
+      return -1;
+   trimend(org);
+   self->organizer= org;
+
+   self->flags |= VCAL_ORG_FLG;
+   return 0;
+}
+
+static int
+prop_LOCATION(VCAL *self, char *line, char *val)
+/******************************************************
+ * Event location.
+ */
+{
+   const char *str= strstr(val, ":");
+   if(!str) {
+      eprintf("ERROR: cannot extract location from  \"%s\"", line);
+      return -1;
+   }
+   ++str;
+   if(!(self->location= ARENA_strndup(&self->arena, str, strlen(str))))
+      return -1;
+
+   self->flags |= VCAL_LOCATION_FLG;
+   return 0;
+}
+
+static int
+prop_SUMMARY(VCAL *self, char *line, char *val)
+/******************************************************
+ * Event summary.
+ */
+{
+   const char *str= strstr(val, ":");
+   if(!str) {
+      eprintf("ERROR: cannot extract summary from  \"%s\"", line);
+      return -1;
+   }
+   ++str;
+   if(!(self->summary= ARENA_strndup(&self->arena, str, strlen(str))))
+      return -1;
+
+   self->flags |= VCAL_SUMMARY_FLG;
+   return 0;
+}
+
+static int
+prop_DESCRIPTION(VCAL *self, char *line, char *val)
+/******************************************************
+ * Event description.
+ */
+{
+   const char *str= strstr(val, ":");
+   if(!str) {
+      eprintf("ERROR: cannot extract description from  \"%s\"", line);
+      return -1;
+   }
+   ++str;
+
+   /* Unescaping never makes a string longer */
+   str= skipspacec(str);
+   char *desc= ARENA_alloc(&self->arena, strlen(str) + 1);
+   if(!desc)
+      return -1;
+   unescape(desc, str);
+
+   /* Get rid of leading and trailing whitespace */
+   trimend(desc);
+   self->description= skipspacec(desc);
+
+   self->flags |= VCAL_DESC_FLG;
+   return 0;
+}
+
+static int
+prop_ATTENDEE(VCAL *self, char *line, char *val)
+/******************************************************
+ * One of the attendees.
+ */
+{
+   (void)line;
+
+   ATND *atnd= ATND_arena_create(&self->arena, val);
+   if(!atnd)
+      return -1;
+
+   PTRVEC_addTail(&self->attendee_vec, atnd);
+   return 0;
+}
+
+static int
+renderTime(VCAL *self, STR *sb, const char *label, time_t when)
+/******************************************************
+ * Append when to sb in each zone we render in, the
+ * first one labeled, the rest lined up under it.
+ * Returns 0 for success, -1 for error.
+ */
+{
+   const VCAL_STYLE *st= &self->style;
+   char buf[64];
+   unsigned i,
+            nZones= PTRVEC_numItems(&self->zone_vec);
+
+   TMFMT_render(nZones ? PTRVEC_first(&self->zone_vec) : &self->tmfmt, buf, sizeof(buf), when);
+   if(-1 == STR_sprintf(sb, "%s%s:%s %s\n", st->REV, label, st->NORMAL, buf))
+      return -1;
+
+   for(i= 1; i < nZones; ++i) {
+      TMFMT_render(PTRVEC_ndxPtr(&self->zone_vec, i), buf, sizeof(buf), when);
+      if(-1 == STR_sprintf(sb, "%*s %s\n", (int)strlen(label) + 1, "", buf))
+         return -1;
+   }
+
+   return 0;
+}
+
+static const TZIF*
+findVtz(VCAL *self, const struct ical_slice *tzid)
+/******************************************************
+ * Find the zone from one of our VTIMEZONE components
+ * for a TZID parameter.
+ */
+{
+   const TZIF *tz;
+   unsigned i;
+   PTRVEC_loopFwd(&self->vtz_vec, i, tz) {
+      if(!strncmp(tz->name, tzid->str, tzid->len) && !tz->name[tzid->len])
+         return tz;
+   }
+
+   return NULL;
+}
+
+static time_t
+vcal2utc(VCAL *self, const char *src)
+/******************************************************
+ * Convert the vcalendar time to UTC time_t
+ */
+{
+   time_t rtn= -1;
+
+   /* The date+time follows the parameters */
+   struct ical_params prm;
+   const char *tm_str= ical_params(src, &prm);
+   if(!tm_str) {
+      eprintf("ERROR: Could not find date+time string in \"%s\"", src);
+      goto abort;
+   }
+
+   /* Initialize a 'struct tm' buffer */
+   struct tm tm= TM_INITIAL;
+   const char *nxt;
+
+   /* Parse string to get populate 'struct tm' */
+   if(!(nxt= ical_strptime(tm_str, &tm))) {
+      eprintf("ERROR: cannot parse date+time \"%s\"", tm_str);
+      goto abort;
+   }
+
+#ifdef qqDEBUG
+eprintf(">>>>> nxt= \"%s\"", nxt);
+#endif
+
+   /* Check to see if date+time string was expressed in UTC */
+   if('Z' == *nxt) { // UTC
+
+      /* Convert 'struct tm' into time_t */
+      rtn= timegm(&tm);
+
+   } else if(!prm.tzid.str) { // Floating, i.e. local wherever you are
+
+      tm.tm_isdst= -1;
+      rtn= mktime(&tm);
+
+   } else { // Some local timezone
+
+      /* Prefer the invite's own definition of the zone */
+      const TZIF *tz= findVtz(self, &prm.tzid);
+      if(!tz) {
+
+         /* Identify the POSIX timezone */
+         const struct tz_xref *xref= tz_xref_find(prm.tzid.str, prm.tzid.len);
+         if(!xref) {
+            eprintf("ERROR: Could not find timezone match for \"%.*s\"", (int)prm.tzid.len, prm.tzid.str);
+            goto abort;
+         }
+
+#ifdef qqDEBUG
+eprintf(">>>>> using timezone \"%s\"", xref->posix);
+#endif
+         if(!(tz= tz_xref_zone(xref)))
+            goto abort;
+      }
+
+      /* Convert 'struct tm' into time_t */
+      rtn= TZIF_mktime(tz, &tm);
+   }
+
+abort:
+   return rtn;
+
+}
+
+static void
+unescape(char *dst, const char *src)
+/******************************************************
+ * Un-escape escaped characters in src into dst, which
+ * has room for at least strlen(src) + 1 bytes. Runs
+ * of plain characters are copied in one go.
+ */
+{
+   for(;;) {
+
+      /* Copy everything up to the next escape as-is */
+      const char *esc= strchr(src, '\\');
+      size_t run= esc ? (size_t)(esc - src) : strlen(src);
+      memcpy(dst, src, run);
+      dst += run;
+
+      if(!esc || !esc[1]) {
+         /* A lone backslash at the end is kept */
+         if(esc)
+            *dst++= '\\';
+         *dst= '\0';
+         return;
+      }
+
+      switch(esc[1]) {
+         case 'n':
+            *dst++= '\n';
+            *dst++= '\t';
+            break;
+
+         case 't':
+            *dst++= '\t';
+            break;
+
+         /* NOTE: There could be other escaped characters,
+          * but I haven't seen them
+          */
+
+         default:
+            /* Escaped character has no special meaning */
+            *dst++= esc[1];
+      }
+
+      src= esc + 2;
+   }
+}
+
+static const char*
+fetchPerson(VCAL *self, const char *src)
+/******************************************************
+ * Fetch person information & supply result in the
+ * context's buffer.
+ */
+{
+   const char *rtn= NULL;
+   STR *sb= &self->person_sb;
+   STR_reset(sb);
+
+   /* Any SENT-BY is ignored */
+   struct ical_params prm;
+   const char *email= ical_params(src, &prm);
+   if(!email || !prm.cn.len || strncasecmp(email, "mailto:", 7))
+      goto abort;
+   email= skipspacec(email + 7);
+
+   int email_len= strcspn(email, " \t\r\n\v\f");
+   if(!email_len)
+      goto abort;
+
+   /* Print formatted info to buffer */
+   if(-1 == STR_sprintf(sb, "%.*s <%.*s>", (int)prm.cn.len, prm.cn.str, email_len, email))
+      goto abort;
+
+   /* Successful return */
+   rtn= STR_str(sb);
+
+abort:
+   if(!rtn)
+      eprintf("ERROR: cannot extract organizer from  \"%s\"", src);
+   return rtn;
+}
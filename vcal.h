@@ -0,0 +1,196 @@
+/************************************************************
+ * Class to parse a Microsoft Outlook vcalendar attachment,
+ * and report what was found.
+ */
+#ifndef VCAL_H
+#define VCAL_H
+
+#include <stdio.h>
+#include <time.h>
+
+#include "arena.h"
+#include "inbuf.h"
+#include "ptrvec.h"
+#include "str.h"
+#include "tmfmt.h"
+
+/* Terminal escape codes used to highlight a report */
+typedef struct _VCAL_STYLE {
+   char BOLD[32],
+        REV[32],
+        NORMAL[32];
+} VCAL_STYLE;
+
+typedef struct _VCAL {
+   /* Flags to make a note of information we've found */
+   enum {
+      VCAL_START_FLG    =1<<0,
+      VCAL_END_FLG      =1<<1,
+      VCAL_SUMMARY_FLG  =1<<2,
+      VCAL_LOCATION_FLG =1<<3,
+      VCAL_ORG_FLG      =1<<4,
+      VCAL_DESC_FLG     =1<<5,
+      VCAL_SCHED_FLG    =1<<6,
+   } flags;
+
+   /* Report information, kept whole however long; "" until found */
+   const char *summary,
+              *location,
+              *organizer,
+              *description;
+
+   /* Time storage for report information */
+   time_t start,
+          end,
+          scheduled;
+
+   /* Vector of ATND objects */
+   PTRVEC attendee_vec;
+
+   /* Holds the strings and ATND objects for the current event, which
+    * are all freed at once when it is done.
+    */
+   ARENA arena;
+
+   /* Zones from this input's VTIMEZONE components; the TZIF
+    * objects belong to tzif.c's cache.
+    */
+   PTRVEC vtz_vec;
+   STR vtz_sb;
+
+   /* The input being parsed */
+   INBUF in;
+
+   /* Scratch buffer for fetchPerson(); too long for its own
+    * buffer, it spills into the arena, not the heap.
+    */
+   STR person_sb;
+
+   /* Where VCAL_report() renders the report */
+   STR report_sb;
+
+   /* Renders times for the report in local time */
+   TMFMT tmfmt;
+
+   /* TMFMT objects for the zones VCAL_addZone() asked for, which
+    * replace local time in the report.
+    */
+   PTRVEC zone_vec;
+
+   /* How the report is highlighted; no escape codes by default */
+   VCAL_STYLE style;
+
+   /* Called at the end of each VEVENT, if set */
+   int (*event_f)(struct _VCAL *self, void *ctxt);
+   void *event_ctxt;
+
+   /* How many VEVENTs have ended in this input */
+   unsigned nEvents;
+
+} VCAL;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define VCAL_create(p) \
+  ((p)=(VCAL_constructor((p)=malloc(sizeof(VCAL))) ? (p) : ( p ? realloc(VCAL_destructor(p),0) : 0 )))
+VCAL*
+VCAL_constructor(VCAL *self);
+/***********************************************
+ * Construct a VCAL.
+ *
+ * returns - pointer to the object, or NULL for failure.
+ */
+
+void*
+VCAL_destructor(VCAL *self);
+/***********************************************
+ * Destruct a VCAL.
+ */
+
+#define VCAL_destroy(p) \
+  do {if(VCAL_destructor(p)) {free(p); p= NULL;}} while(0)
+
+void
+VCAL_reset(VCAL *self);
+/***********************************************
+ * Discard what we know about the last input,
+ * keeping the buffers for the next one.
+ */
+
+void
+VCAL_setEventHandler(VCAL *self, int (*event_f)(VCAL *self, void *ctxt), void *ctxt);
+/***********************************************
+ * Have event_f called as soon as each VEVENT ends,
+ * with ctxt. It may render or otherwise look at the
+ * event; afterwards the event is forgotten, so memory
+ * use is bounded by one event however many there
+ * are. If event_f returns -1, parsing stops with an
+ * error. With no handler, each VEVENT replaces the
+ * one before, and the last is left for VCAL_report().
+ */
+
+int
+VCAL_addZone(VCAL *self, const char *name);
+/***********************************************
+ * Render times in the report in the POSIX timezone
+ * name (e.g. "Europe/Berlin"). Call once for each
+ * zone wanted; they are listed in the order added,
+ * instead of local time.
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+int
+VCAL_parseFile(VCAL *self, const char *path);
+/***********************************************
+ * Parse a vcalendar file ("-" for stdin), and
+ * make note of what we find.
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+int
+VCAL_parseBuf(VCAL *self, const char *buf, size_t buf_len);
+/***********************************************
+ * Same as VCAL_parseFile(), except the vcalendar
+ * input is in memory.
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+int
+VCAL_parseRegion(VCAL *self, char *buf, size_t len);
+/***********************************************
+ * Same as VCAL_parseBuf(), except buf is parsed
+ * in place rather than copied; see
+ * INBUF_openRegion(). This lets threads parse
+ * pieces of one mmap()'d input side by side.
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+int
+VCAL_render(VCAL *self, STR *sb);
+/***********************************************
+ * Append the report for what VCAL_parseFile() found
+ * to sb.
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+int
+VCAL_report(VCAL *self, FILE *fh);
+/***********************************************
+ * Print the report for what VCAL_parseFile() found.
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,7 +3,7 @@
  * attachments, and display the times unambiguously in *your* local timezone.
  *
  * If you need to add new MS Outlook <-> POSIX timezone mappings, place them
- * below in Ms2Posix[].
+ * in Ms2Posix[] in tz_xref.c.
  * 
  * Tue Apr  6 11:23:22 EDT 2021
  * John Robertson <john@rrci.com>
@@ -11,68 +11,74 @@
 
 #define _GNU_SOURCE
 #include <assert.h>
+#include <dirent.h>
 #include <getopt.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 
-#include "atnd.h"
 #include "ez_libc.h"
 #include "ptrvec.h"
-#include "str.h"
-#include "tz_xref.h"
 #include "util.h"
+#include "vcal.h"
 #include "vcalendar.h"
-
-/* My preferred output format for date+time */
-#define STRFTIME_FMT "%H:%M %A %B %d, %Y %Z"
+#include "workpool.h"
 
 /*===========================================================================*/
 /*=================== Forward declarations ==================================*/
 /*===========================================================================*/
-/* Can't get the #define _XOPEN_SOURCE thing to work */
-char *strptime(const char *s, const char *format, struct tm *tm);
+struct job;
 
 /* Application-specific functions */
-static time_t vcal2utc(const char *src);
-static const char *unescape(const char *src);
-static const char *fetchPerson(const char *src);
+static int processPath(const char *path);
+static int processDir(const char *dirName);
+static int submitFile(const char *path);
+static int submitPieces(const char *path);
+static int processPiece(VCAL *vcal, const struct job *job, FILE *out);
+static int processFile(VCAL *vcal, const char *path, FILE *out);
+static int reportEvent(VCAL *vcal, void *ctxt);
+static int setupVcal(VCAL *vcal);
+static void job_work(void *arg, unsigned worker_ndx);
+static void job_done(void *arg);
+static void job_eprintf_line(const char *msg);
 
 /*===========================================================================*/
 /*=================== static data ===========================================*/
 /*===========================================================================*/
 
-/* Instance the global static data */
-struct Global G;
+/* Terminal escape codes, if any */
+static VCAL_STYLE G;
 
-/*** Main information for code in this source file ***/
+/*** Program-wide information, shared by all threads ***/
 static struct {
-   /* Flags to make a note of information we've found */
-   enum {
-      START_FLG    =1<<0,
-      END_FLG      =1<<1,
-      SUMMARY_FLG  =1<<2,
-      LOCATION_FLG =1<<3,
-      ORG_FLG      =1<<4,
-      DESC_FLG     =1<<5,
-      SCHED_FLG    =1<<6,
-   } flags;
-
-   /* String storage for report information */
-   char summary[1024],
-        location[1024],
-        organizer[1024],
-        description[4096];
-
-   /* Time storage for report information */
-   time_t start,
-          end,
-          scheduled;
-
-   /* Vector of ATND objects */
-   PTRVEC attendee_vec;
+
+   /* Set when reports are labeled with the input name */
+   int is_batch;
+
+   /* How many threads parse files */
+   unsigned nJobs;
+
+   /* Parser context for the main thread */
+   VCAL vcal;
+
+   /* Worker threads, if nJobs > 1 */
+   WORKPOOL *pool;
+
+   /* Parser context for each worker thread */
+   VCAL *vcalArr;
+
+   /* Count of inputs which failed in the worker pool */
+   unsigned nErrs;
+
+   /* Comma separated zones from --tz, if any */
+   const char *zones;
+
+   /* Where error messages went before the worker pool started */
+   eprintf_line_f prev_eprintf_line;
 
    struct {
       int major,
@@ -80,10 +86,70 @@ static struct {
           patch;
    } version;
 
-} S= {
-   .version.major= 0,
-   .version.minor= 2,
-   .version.patch= 0
+} P= {
+   .nJobs= 1,
+   .version.major= VCALENDAR_VERSION_MAJOR,
+   .version.minor= VCALENDAR_VERSION_MINOR,
+   .version.patch= VCALENDAR_VERSION_PATCH
+};
+
+/* Files at least this big are split into pieces for the worker pool */
+#define SPLIT_MIN_SZ (1024*1024)
+
+/* No piece is smaller than this */
+#define PIECE_MIN_SZ (256*1024)
+
+/* --jobs is held to this many per processor */
+#define MAX_JOBS_PER_CPU 4
+
+/* A large file, parsed in pieces by the worker pool */
+struct split {
+
+   /* The whole file */
+   INBUF in;
+
+   /* Copy of what comes before the first VEVENT, which holds the
+    * VTIMEZONEs every piece needs. Files with a VTIMEZONE further
+    * on are not split.
+    */
+   char *prologue;
+   size_t prologue_len;
+
+   /* Set once a piece has failed; the pieces after it are dropped,
+    * as a parse of the whole file would have stopped there.
+    */
+   atomic_int has_failed;
+};
+
+/* A file, or piece of one, to be processed in the worker pool */
+struct job {
+   char *path;
+
+   /* For a piece of a file, [off, off + len) of split->in */
+   struct split *split;
+   size_t off,
+          len;
+   int is_first,
+       is_last;
+
+   /* Report, and error messages, as rendered by the worker */
+   char *out,
+        *err;
+   size_t out_sz,
+          err_sz;
+
+   int rc;
+};
+
+/* Where a worker thread's error messages go while it does a job */
+static _Thread_local FILE *Job_err_fh;
+
+/* Where reportEvent() prints */
+struct sink {
+   FILE *out;
+
+   /* Set once an event has been printed */
+   int has_events;
 };
 
 /*===========================================================================*/
@@ -93,7 +159,10 @@ static struct {
 /* Enums for long options */
 enum {
    VERSION_OPT_ENUM=128, /* Larger than any printable character */
-   HELP_OPT_ENUM
+   HELP_OPT_ENUM,
+   JOBS_OPT_ENUM,
+   NULL_OPT_ENUM,
+   TZ_OPT_ENUM
 };
 
 /*===========================================================================*/
@@ -105,9 +174,8 @@ main(int argc, char **argv)
  * Program execution begins here.
  */
 {
-   int rtn= EXIT_FAILURE;
-   /* Static data construction */
-   PTRVEC_constructor(&S.attendee_vec, 10);
+   int rtn= EXIT_FAILURE,
+       null_list= 0;
 
    { /****** Command line option processing ******/
       extern char *optarg;
@@ -116,6 +184,9 @@ main(int argc, char **argv)
       for(;;) {
 
          static const struct option long_options[]= {
+            {"jobs", required_argument, 0, JOBS_OPT_ENUM},
+            {"null", no_argument, 0, NULL_OPT_ENUM},
+            {"tz", required_argument, 0, TZ_OPT_ENUM},
             {"version", no_argument, 0, VERSION_OPT_ENUM},
             {"help", no_argument, 0, HELP_OPT_ENUM},
             {/* Terminating member */}
@@ -128,8 +199,41 @@ main(int argc, char **argv)
 
          switch(c) {
 
+            case JOBS_OPT_ENUM:
+               {
+                  char *end;
+                  long n= strtol(optarg, &end, 10);
+                  if(*end || 0 > n) {
+                     eprintf("ERROR: \"%s\" is not a valid number of jobs", optarg);
+                     ++errflg;
+                     break;
+                  }
+                  /* Zero means use every processor; more than a few per processor
+                   * would just be threads and parsers sitting idle.
+                   */
+                  long nCpus= sysconf(_SC_NPROCESSORS_ONLN);
+                  if(1 > nCpus) nCpus= 1;
+                  if(!n) n= nCpus;
+                  if(n > MAX_JOBS_PER_CPU * nCpus) n= MAX_JOBS_PER_CPU * nCpus;
+                  P.nJobs= n;
+               }
+               break;
+
+            case NULL_OPT_ENUM:
+               null_list= 1;
+               break;
+
+            case TZ_OPT_ENUM:
+               P.zones= optarg;
+               break;
+
+            case ':':
+               eprintf("ERROR: option \"%s\" requires an argument", argv[optind-1]);
+               ++errflg;
+               break;
+
             case VERSION_OPT_ENUM:
-               ez_fprintf(stdout, "%s v%d.%d.%d\n", argv[0], S.version.major, S.version.minor, S.version.patch);
+               ez_fprintf(stdout, "%s v%d.%d.%d\n", argv[0], P.version.major, P.version.minor, P.version.patch);
                fflush(stdout);
                return EXIT_SUCCESS;
 
@@ -143,8 +247,13 @@ main(int argc, char **argv)
       if(errflg) {
          ez_fprintf(stderr,
             "Usage:\n"
-            "%s [options] [vcalendar_file]\n"
+            "%s [options] [vcalendar_file | directory ...]\n"
             " vcalendar_file\t\tMS Outlook vcalendar attachment (if absent, stdin is used).\n"
+            " directory\t\tprocess every file found in directory.\n"
+            " --jobs N\t\tparse N files, or pieces of a big file, at a time (0 uses every processor,\n"
+            "\t\t\tat most 4 per processor).\n"
+            " --null\t\t\tread a NUL separated list of file names from stdin.\n"
+            " --tz zone[,zone...]\tshow times in these POSIX timezones instead of local time.\n"
             " --help\t\t\tprint this Help message and exit.\n"
             " --version\t\tprint program Version numbers.\n"
             , argv[0]
@@ -172,388 +281,525 @@ main(int argc, char **argv)
       ez_pclose(fh);
    }
 
+   /* More than one input means we label each report */
+   P.is_batch= null_list || 1 < argc - optind;
 
-   static char buf[4096];
-   FILE *fh= stdin;
-
-   /*======= File name may have been supplied on command line =======*/
-   if(1 < argc)
-      fh= ez_fopen(argv[1], "r");
+   if(!VCAL_constructor(&P.vcal) || setupVcal(&P.vcal)) {
+      eprintf("ERROR: cannot construct parser context");
+      goto abort;
+   }
 
-   /*===========================================================================*/
-   /*================ Grab one line at a time from source ======================*/
-   /*===========================================================================*/
-   while (ez_fgets(buf, sizeof(buf) - 1, fh)) {
+   /* Start worker threads if asked */
+   if(1 < P.nJobs) {
 
-      /* Get rid of whitespace on the end */
-      trimend(buf);
+      if(!(P.vcalArr= calloc(P.nJobs, sizeof(VCAL)))) {
+         sys_eprintf("ERROR: calloc() failed");
+         goto abort;
+      }
 
-      /** Possible continuation(s) **/
-      while(!feof(fh)) {
+      unsigned i;
+      for(i= 0; i < P.nJobs; ++i) {
+         if(!VCAL_constructor(P.vcalArr + i) || setupVcal(P.vcalArr + i)) {
+            eprintf("ERROR: cannot construct parser context");
+            goto abort;
+         }
+      }
 
-         int bol= fgetc(fh);
+      /* Workers' error messages come out with their reports */
+      P.prev_eprintf_line= set_eprintf_line(job_eprintf_line);
 
-         if(' ' != bol) { /* Not a continutation, put back & quit loop */
-            ungetc(bol, fh);
-            break;
-         }
-         
-         size_t sz= strlen(buf);
-         ez_fgets(buf+sz, sizeof(buf)-sz - 1, fh);
-         trimend(buf);
+      if(!WORKPOOL_create(P.pool, P.nJobs, 4 * P.nJobs, job_work, job_done)) {
+         eprintf("ERROR: cannot create worker pool");
+         goto abort;
       }
+   }
 
-      /*---------------------------------------------------------------------------*/
-      /*-------------------- Process reassembled line -----------------------------*/
-      /*---------------------------------------------------------------------------*/
-      if(!strncmp(buf, "DTSTART;TZID=", 13)) { // Start time of the event
-#ifdef qqDEBUG
-eprintf(">>>>> buf= \"%s\"", buf);
-#endif
-         S.start= vcal2utc(buf + 13);
-         if(-1 == S.start)
-            goto abort;
+   unsigned nErrs= 0;
 
-         S.flags |= START_FLG;
+   if(null_list) {
+      /*======= NUL separated file names arrive on stdin =======*/
+      char *path= NULL;
+      size_t path_sz= 0;
+      while(-1 != getdelim(&path, &path_sz, '\0', stdin)) {
+         if(!*path) continue;
+         if(processPath(path)) ++nErrs;
+      }
+      free(path);
 
-      } else if(!strncmp(buf, "DTEND;TZID=", 11)) { // End time of the event
+   } else if(optind < argc) {
+      /*======= File names were supplied on command line =======*/
+      for(; optind < argc; ++optind) {
+         if(processPath(argv[optind])) ++nErrs;
+      }
 
-         S.end= vcal2utc(buf + 11);
-         if(-1 == S.end)
-            goto abort;
+   } else {
+      /*======= Use stdin =======*/
+      if(submitFile("-")) ++nErrs;
+   }
 
-         S.flags |= END_FLG;
+   /* Wait for the worker pool to finish */
+   if(P.pool)
+      WORKPOOL_destroy(P.pool);
 
-      } else if(!strncmp(buf, "DTSTAMP:", 8)) { // When meeting was scheduled, UTC
+   if(nErrs || P.nErrs)
+      goto abort;
 
-         const char *tm_str= buf + 7; // NOTE: vcal2utc() needs the preceding colon
+   /* Successful */
+   rtn= EXIT_SUCCESS;
 
-         /* Convert 'struct tm' into time_t */
-         S.scheduled= vcal2utc(tm_str);
-         if(-1 == S.scheduled)
-            goto abort;
+abort:
+   return rtn;
+}
 
-         S.flags |= SCHED_FLG;
+/*===========================================================================*/
+/*===================== input processing ====================================*/
+/*===========================================================================*/
 
-      } else if(!strncmp(buf, "ORGANIZER;", 10)) { //  Event organizer
+static int
+processPath(const char *path)
+/******************************************************
+ * Process a file, or every file in a directory.
+ * Returns 0 for success, -1 for error.
+ */
+{
+   int rtn= -1;
+   struct stat st;
 
-         /* Fetch formatted personal information */
-         const char *str= fetchPerson(buf + 10);
+   if(!strcmp(path, "-")) {
+      rtn= submitFile(path);
+      goto abort;
+   }
 
-         if(!str)
-            goto abort;
+   if(-1 == stat(path, &st)) {
+      sys_eprintf("ERROR: stat(\"%s\") failed", path);
+      goto abort;
+   }
 
-         strncpy(S.organizer, skipspacec(str), sizeof(S.organizer) - 1);
-         trimend(S.organizer);
-         S.flags |= ORG_FLG;
+   if(S_ISDIR(st.st_mode)) {
+      rtn= processDir(path);
+      goto abort;
+   }
 
-      } else if(!strncmp(buf, "LOCATION;", 9)) { // Event location
+   rtn= submitFile(path);
 
-         const char *line= strstr(buf + 9, ":");
-         if(!line) {
-            eprintf("ERROR: cannot extract location from  \"%s\"", buf);
-            goto abort;
-         }
-         ++line;
-         strncpy(S.location, line, sizeof(S.location) - 1);
+abort:
+   return rtn;
+}
 
-         S.flags |= LOCATION_FLG;
+static int
+path_ptrvec_cmp(const void *const* pp1, const void *const* pp2)
+/******************************************************
+ * Comparision function for PTRVEC_stableSort() of file names.
+ */
+{
+   return strcmp(*(const char *const*)pp1, *(const char *const*)pp2);
+}
 
-      } else if(!strncmp(buf, "SUMMARY;", 8)) { //  Event summary
+static int
+processDir(const char *dirName)
+/******************************************************
+ * Process every regular file in a directory, in
+ * file name order.
+ * Returns 0 for success, -1 for error.
+ */
+{
+   int rtn= 0;
+   PTRVEC path_vec;
+   PTRVEC_constructor(&path_vec, 64);
+
+   /* Many reports are coming, so label them */
+   P.is_batch= 1;
+
+   /* Like a file which can't be read, skip it and carry on */
+   DIR *dir= opendir(dirName);
+   if(!dir) {
+      sys_eprintf("ERROR: opendir(\"%s\") failed", dirName);
+      rtn= -1;
+      goto abort;
+   }
 
-         const char *line= strstr(buf + 8, ":");
-         if(!line) {
-            eprintf("ERROR: cannot extract summary from  \"%s\"", buf);
-            goto abort;
-         }
-         ++line;
-         strncpy(S.summary, line, sizeof(S.summary) - 1);
+   struct dirent *ent;
+   while((ent= ez_readdir(dir))) {
 
-         S.flags |= SUMMARY_FLG;
+      /* Skip hidden files, "." and ".." */
+      if('.' == ent->d_name[0]) continue;
 
-      } else if(!strncmp(buf, "DESCRIPTION;", 12)) { // Event description
+      char *path;
+      if(-1 == asprintf(&path, "%s/%s", dirName, ent->d_name)) {
+         sys_eprintf("ERROR: asprintf() failed");
+         abort();
+      }
 
-         const char *line= strstr(buf + 8, ":");
-         if(!line) {
-            eprintf("ERROR: cannot extract description from  \"%s\"", buf);
-            goto abort;
-         }
-         ++line;
+      struct stat st;
+      if(-1 == stat(path, &st) || !S_ISREG(st.st_mode)) {
+         free(path);
+         continue;
+      }
 
-         /* Copy unescaped string to our storage location */
-         strncpy(S.description, skipspacec(unescape(line)), sizeof(S.description) - 1 );
+      PTRVEC_addTail(&path_vec, path);
+   }
+   ez_closedir(dir);
 
-         /* Get rid of trailing whitespace */
-         trimend(S.description);
+   PTRVEC_stableSort(&path_vec, path_ptrvec_cmp, P.nJobs);
 
-         S.flags |= DESC_FLG;
+   char *path;
+   while((path= PTRVEC_remHead(&path_vec))) {
+      if(processPath(path)) rtn= -1;
+      free(path);
+   }
 
-      } else if(!strncmp(buf, "ATTENDEE;", 9)) { // Attendees
+abort:
+   PTRVEC_destructor(&path_vec);
+   return rtn;
+}
 
-         ATND *atnd;
-         ATND_create(atnd, buf+9);
-         if(!atnd)
-            goto abort;
+static int
+submitFile(const char *path)
+/******************************************************
+ * Process a file now, or hand it to the worker pool.
+ * Returns 0 for success, -1 for error.
+ */
+{
+   if(!P.pool)
+      return processFile(&P.vcal, path, stdout);
 
-         PTRVEC_addTail(&S.attendee_vec, atnd);
-      }
+   /* One big file could keep the whole pool busy */
+   if(!submitPieces(path))
+      return 0;
+
+   struct job *job= calloc(1, sizeof(*job));
+   if(!job || !(job->path= strdup(path))) {
+      sys_eprintf("ERROR: memory allocation failed");
+      abort();
    }
 
-   /*===========================================================================*/
-   /*===================== Print report ========================================*/
-   /*===========================================================================*/
-   if(S.flags & START_FLG)
-      ez_fprintf(stdout, "%sEvent start:%s %s\n"
-            , G.REV
-            , G.NORMAL
-            , local_strftime(&S.start, STRFTIME_FMT)
-            );
+   WORKPOOL_submit(P.pool, job);
+   return 0;
+}
 
-   if(S.flags & END_FLG)
-      ez_fprintf(stdout, "%s  Event end:%s %s\n"
-            , G.REV
-            , G.NORMAL
-            , local_strftime(&S.end, STRFTIME_FMT)
-            );
+static int
+submitPieces(const char *path)
+/******************************************************
+ * If path is big enough to be worth it, split it at
+ * VEVENTs into about 4 pieces per worker, and hand
+ * them to the worker pool. The reports come out in
+ * order, so it looks as though the file was parsed
+ * in one go.
+ * Returns 0 if the pieces were submitted, -1 if the
+ * file should be processed whole.
+ */
+{
+   int rtn= -1;
+   struct stat st;
+   struct split *split= NULL;
+   size_t *offArr= NULL;
 
-   if(S.flags & SUMMARY_FLG)
-      ez_fprintf(stdout, "\n%sSummary:%s %s%s\n\t%s\n"
-            , G.REV
-            , G.NORMAL
-            , S.flags & SCHED_FLG ? "As of " : ""
-            , S.flags & SCHED_FLG ? local_strftime(&S.scheduled, STRFTIME_FMT) : ""
-            , S.summary
-            );
+   if(-1 == stat(path, &st) || !S_ISREG(st.st_mode) || SPLIT_MIN_SZ > st.st_size)
+      goto abort;
 
-   if(S.flags & LOCATION_FLG)
-      ez_fprintf(stdout, "\n%sEvent location:%s %s\n"
-            , G.REV
-            , G.NORMAL
-            , S.location
-            );
+   unsigned nPieces= 4 * P.nJobs;
+   if(nPieces > st.st_size / PIECE_MIN_SZ)
+      nPieces= st.st_size / PIECE_MIN_SZ;
 
-   if(S.flags & ORG_FLG)
-      ez_fprintf(stdout, "\n%sEvent organizer:%s %s\n"
-            , G.REV
-            , G.NORMAL
-            , S.organizer
-            );
+   if(!(split= calloc(1, sizeof(*split))) ||
+      !(offArr= malloc((nPieces + 1) * sizeof(*offArr))))
+   {
+      sys_eprintf("ERROR: memory allocation failed");
+      abort();
+   }
 
-   if(S.flags & DESC_FLG)
-      ez_fprintf(stdout, "\n%sDescription:%s\n\t%s\n"
-            , G.REV
-            , G.NORMAL
-            , S.description
-            );
+   /* Problems opening the file will be reported when it is processed whole */
+   INBUF_constructor(&split->in);
+   if(INBUF_open(&split->in, path))
+      goto abort;
 
-   /* Attendees */
-   PTRVEC_sort(&S.attendee_vec, ATND_ptrvec_cmp);
-   if(PTRVEC_numItems(&S.attendee_vec)) {
-      ez_fprintf(stdout, "\n%sAttendees:%s\n"
-            , G.REV
-            , G.NORMAL
-            );
-      unsigned i;
-      ATND *atnd;
-      PTRVEC_loopFwd(&S.attendee_vec, i, atnd) {
-         ATND_report(atnd, stdout);
-      }
-   }
+   INBUF *in= &split->in;
 
-   /* Successful */
-   rtn= EXIT_SUCCESS;
+   /*--- Cut at the first VEVENT after each nth of the file ---*/
+   size_t first= INBUF_findLine(in, 0, "BEGIN:VEVENT");
+   if(first == in->len)
+      goto abort;
 
-abort:
-   return rtn;
-}
+   /* Events after a later VTIMEZONE may need it, and events before
+    * it must not see it, so such a file is parsed whole.
+    */
+   if(INBUF_findLine(in, first, "BEGIN:VTIMEZONE") != in->len)
+      goto abort;
 
-/*===========================================================================*/
-/*===================== supporting functions ================================*/
-/*===========================================================================*/
+   unsigned i,
+            n= 0;
+   offArr[n++]= 0;
+   for(i= 1; i < nPieces; ++i) {
 
-static time_t
-vcal2utc(const char *src)
-/******************************************************
- * Convert the vcalendar time to UTC time_t
- */
-{
-   time_t rtn= -1;
-   /* Find the ": sequence preceding the UTC time */
-#ifdef qqDEBUG
-eprintf(">>>>> src= \"%s\"", src);
-#endif
+      size_t from= in->len / nPieces * i;
+      if(from <= offArr[n-1])
+         from= offArr[n-1] + 1;
+      if(from < first)
+         from= first + 1;
+
+      size_t off= INBUF_findLine(in, from, "BEGIN:VEVENT");
+      if(off == in->len)
+         break;
+      offArr[n++]= off;
+   }
+   offArr[n]= in->len;
 
-   const char *tm_str;
-   if(strchr(src, '"')) {
+   if(2 > n)
+      goto abort;
 
-      /*-- Case for Microsoft timezone "display name" --*/
-      tm_str= strstr(src, "\":");
+   if(!(split->prologue= malloc(first))) {
+      sys_eprintf("ERROR: malloc(%zu) failed", first);
+      abort();
+   }
+   memcpy(split->prologue, in->buf, first);
+   split->prologue_len= first;
 
-      /* Make sure we found it */
-      if(!tm_str) {
-         eprintf("ERROR: Could not find date+time string in \"%s\"", src);
-         goto abort;
+   for(i= 0; i < n; ++i) {
+
+      struct job *job= calloc(1, sizeof(*job));
+      if(!job || !(job->path= strdup(path))) {
+         sys_eprintf("ERROR: memory allocation failed");
+         abort();
       }
 
-      /* Skip over sentinel chars */
-      tm_str += 2;
+      job->split= split;
+      job->off= offArr[i];
+      job->len= offArr[i+1] - offArr[i];
+      job->is_first= !i;
+      job->is_last= i + 1 == n;
 
-   } else {
+      WORKPOOL_submit(P.pool, job);
+   }
 
-      /*-- Case for regular Microsoft timezone --*/
-      tm_str= strstr(src, ":");
-      /* Make sure we found it */
-      if(!tm_str) {
-         eprintf("ERROR: Could not find date+time string in \"%s\"", src);
-         goto abort;
-      }
+   /* The last piece frees split */
+   split= NULL;
 
-      /* Skip over sentinel chars */
-      tm_str += 1;
+   rtn= 0;
+abort:
+   if(split) {
+      INBUF_destructor(&split->in);
+      free(split);
    }
+   if(offArr) free(offArr);
+   return rtn;
+}
 
-   /* Initialize a 'struct tm' buffer */
-   struct tm tm= TM_INITIAL;
-   char *nxt;
+static void
+job_work(void *arg, unsigned worker_ndx)
+/******************************************************
+ * Process a file on a worker thread, rendering the
+ * report to memory.
+ */
+{
+   struct job *job= arg;
 
-   /* Parse string to get populate 'struct tm' */
-   if(!(nxt= strptime(tm_str, "%Y%m%dT%H%M%S", &tm))) {
-      eprintf("ERROR: strptime failed parsing \"%s\"", tm_str);
-      goto abort;
+   /* An earlier piece failed, so this one would be dropped anyway */
+   if(job->split && atomic_load_explicit(&job->split->has_failed, memory_order_relaxed))
+      return;
+
+   FILE *fh= open_memstream(&job->out, &job->out_sz),
+        *err_fh= open_memstream(&job->err, &job->err_sz);
+   if(!fh || !err_fh) {
+      sys_eprintf("ERROR: open_memstream() failed");
+      abort();
    }
 
-#ifdef qqDEBUG
-eprintf(">>>>> nxt= \"%s\"", nxt);
-#endif
+   Job_err_fh= err_fh;
+   if(job->split)
+      job->rc= processPiece(P.vcalArr + worker_ndx, job, fh);
+   else
+      job->rc= processFile(P.vcalArr + worker_ndx, job->path, fh);
+   Job_err_fh= NULL;
 
-   /* Check to see if date+time string was expressed in UTC */
-   if('Z' == *nxt) { // UTC
+   ez_fclose(fh);
+   ez_fclose(err_fh);
+}
 
-      /* Convert 'struct tm' into time_t */
-      rtn= timegm(&tm);
+static void
+job_done(void *arg)
+/******************************************************
+ * Print the report for a file processed by the worker
+ * pool. These are called in the same order the files
+ * were submitted.
+ */
+{
+   struct job *job= arg;
 
-   } else { // Some local timezone
+   if(job->split && atomic_load_explicit(&job->split->has_failed, memory_order_relaxed)) {
 
-      /* If TZ is set, make a copy of it now */
-      const char *TZ_orig= getenv("TZ");
+      /* Dropped, but the file's report still ends as usual */
+      if(P.is_batch && job->is_last)
+         ez_fputc('\n', stdout);
 
-      /* Identify the POSIX timezone, and set it */
-      const struct tz_xref *xref;
-      for(xref= Ms2Posix; xref->ms; ++xref) {
-#ifdef qqDEBUG
-eprintf(">>>>> src= \"%s\", xref->ms= \"%s\"", src, xref->ms);
-#endif
+   } else {
 
-         if(strncasecmp(src, xref->ms, strlen(xref->ms)))
-            continue;
+      if(job->out_sz)
+         ez_fwrite(job->out, job->out_sz, 1, stdout);
 
-#ifdef qqDEBUG
-eprintf(">>>>> setting TZ=\"%s\"", xref->posix);
-#endif
-         setenv("TZ", xref->posix, 1);
-         break;
+      if(job->err_sz) {
+         ez_fflush(stdout);
+         ez_fwrite(job->err, job->err_sz, 1, stderr);
+         ez_fflush(stderr);
       }
 
-      /* Make sure we didn't reach the end */
-      if(!xref->ms) {
-         eprintf("ERROR: Could not find timezone match for \"%s\"", src);
-         goto abort;
+      if(job->rc) {
+         ++P.nErrs;
+         if(job->split)
+            atomic_store_explicit(&job->split->has_failed, 1, memory_order_relaxed);
       }
+   }
 
-      /* Convert 'struct tm' into time_t */
-      rtn= mktime(&tm);
+   /* The last piece of a file is done with it */
+   if(job->is_last) {
+      INBUF_destructor(&job->split->in);
+      free(job->split->prologue);
+      free(job->split);
+   }
+
+   free(job->out);
+   free(job->err);
+   free(job->path);
+   free(job);
+}
 
-      /* Now switch the TZ back to what it was (if anything) */
-      if(TZ_orig)
-         setenv("TZ", TZ_orig, 1);
-      else
-         unsetenv("TZ");
+static void
+job_eprintf_line(const char *msg)
+/******************************************************
+ * Print an error message. On a worker thread doing a
+ * job, it goes with the job's report, to be printed
+ * in order by job_done().
+ */
+{
+   if(!Job_err_fh) {
+      (*P.prev_eprintf_line)(msg);
+      return;
    }
 
-abort:
-   return rtn;
+   ez_fputs(msg, Job_err_fh);
+   ez_fputc('\n', Job_err_fh);
+}
+
+static int
+setupVcal(VCAL *vcal)
+/******************************************************
+ * Apply the command line options to a parser context.
+ * Returns 0 for success, -1 for error.
+ */
+{
+   vcal->style= G;
+
+   if(!P.zones)
+      return 0;
+
+   /* Each zone is loaded once, however many contexts render in it */
+   char zone[256];
+   const char *p= P.zones;
+   while(*p) {
+      size_t len= strcspn(p, ",");
+      if(len && len < sizeof(zone)) {
+         memcpy(zone, p, len);
+         zone[len]= '\0';
+         if(VCAL_addZone(vcal, zone))
+            return -1;
+      } else if(len) {
+         eprintf("ERROR: timezone name is too long");
+         return -1;
+      }
+      p += len;
+      if(',' == *p) ++p;
+   }
 
+   return 0;
 }
 
-static const char*
-unescape(const char *src)
+static int
+processFile(VCAL *vcal, const char *path, FILE *out)
 /******************************************************
- * Un-escape escaped characters in string, return result
- * in a static buffer
+ * Parse one vcalendar input with vcal, print the report
+ * to out, and reset vcal for the next input.
+ * Returns 0 for success, -1 for error.
  */
 {
-   static STR sb;
-   STR_sinit(&sb, 1024);
-   for(; *src; ++src) {
-
-      /* Check for possible escaped character */
-      if('\\' == *src && *(src+1)) {
-         switch(*(src+1)) {
-            case 'n':
-               STR_append(&sb, "\n\t", 2);
-               break;
+   int rtn= -1;
 
-            case 't':
-               STR_putc(&sb, '\t');
-               break;
+   if(P.is_batch)
+      ez_fprintf(out, "%s==> %s <==%s\n"
+            , G.BOLD
+            , path
+            , G.NORMAL
+            );
 
-            /* NOTE: There could be other escaped characters,
-             * but I haven't seen them
-             */
+   /* Each event is reported as soon as it ends */
+   struct sink sink= {.out= out};
+   VCAL_setEventHandler(vcal, reportEvent, &sink);
 
-            default:
-               /* Escaped character has no special meaning */
-               STR_putc(&sb, *(src+1));
-         }
+   rtn= VCAL_parseFile(vcal, path);
 
-         ++src;
-         continue;
-      }
+   /* Input without VEVENT components still gets a report */
+   if(!rtn && !vcal->nEvents)
+      VCAL_report(vcal, out);
 
-      /* Otherwise copy character as-is */
-      STR_putc(&sb, *src);
-   }
+   /* Separate reports from each other */
+   if(P.is_batch)
+      ez_fputc('\n', out);
 
-   return STR_str(&sb);
+   VCAL_reset(vcal);
+
+   return rtn;
 }
 
-static const char*
-fetchPerson(const char *src)
+static int
+processPiece(VCAL *vcal, const struct job *job, FILE *out)
 /******************************************************
- * Fetch person information & supply result in static
- * buffer.
+ * Like processFile(), but for one piece of a file
+ * split by submitPieces().
+ * Returns 0 for success, -1 for error.
  */
 {
-   const char *rtn= NULL;
-   static STR sb;
-   STR_sinit(&sb, 1024);
-
-   int n;
-   char name[64],
-        email[128];
+   int rtn= -1;
+   struct split *split= job->split;
 
-   const char *str= strstr(src, "CN=");
-   if(!str)
-      goto abort;
+   if(P.is_batch && job->is_first)
+      ez_fprintf(out, "%s==> %s <==%s\n"
+            , G.BOLD
+            , job->path
+            , G.NORMAL
+            );
 
-   str += 3;
+   /* Earlier pieces have printed events */
+   struct sink sink= {.out= out, .has_events= !job->is_first};
+   VCAL_setEventHandler(vcal, reportEvent, &sink);
 
-   if(2 == sscanf(str, "%63[^:]:MAILTO:%127s", name, email) ||
-      2 == sscanf(str, "%63[^:]:mailto:%127s", name, email) ||
-      2 == sscanf(str, "%63[^;];SENT-BY=\"%*[^\"]\":MAILTO:%127s", name, email) ||
-      2 == sscanf(str, "%63[^;];SENT-BY=\"%*[^\"]\":mailto:%127s", name, email) 
-      )
-   {
-      /* Print formatted info to buffer */
-      STR_sprintf(&sb, "%s <%s>", name, email);
-   } else
+   /* The first piece has the prologue already */
+   if(!job->is_first && VCAL_parseBuf(vcal, split->prologue, split->prologue_len))
       goto abort;
 
-   /* Successful return */
-   rtn= STR_str(&sb);
+   rtn= VCAL_parseRegion(vcal, split->in.buf + job->off, job->len);
 
 abort:
-   if(!rtn)
-      eprintf("ERROR: cannot extract organizer from  \"%s\"", src);
+   /* Separate reports from each other */
+   if(P.is_batch && job->is_last)
+      ez_fputc('\n', out);
+
+   VCAL_reset(vcal);
+
    return rtn;
 }
+
+static int
+reportEvent(VCAL *vcal, void *ctxt)
+/******************************************************
+ * Print the report for the event vcal just finished
+ * parsing to the struct sink ctxt.
+ */
+{
+   struct sink *sink= ctxt;
+
+   /* Separate events from each other */
+   if(sink->has_events)
+      ez_fputc('\n', sink->out);
+   sink->has_events= 1;
+
+   VCAL_report(vcal, sink->out);
+   return 0;
+}
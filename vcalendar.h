@@ -1,13 +1,159 @@
+/************************************************************
+ * libvcalendar - interpret Microsoft Outlook vcalendar
+ * attachments in-process.
+ *
+ * This is the stable interface to the library; the layout of
+ * the parser context is private, so programs built against
+ * one version keep working with the next. Functions only get
+ * added here, never changed.
+ */
 #ifndef VCALENDAR_H
 #define VCALENDAR_H
 
-struct Global {
-   /* Terminal escape codes, if any */
-   char BOLD[32],
-        REV[32],
-        NORMAL[32];
+#include <stddef.h>
+#include <time.h>
+
+#define VCALENDAR_VERSION_MAJOR 0
+#define VCALENDAR_VERSION_MINOR 5
+#define VCALENDAR_VERSION_PATCH 0
+
+/* Marks what libvcalendar.so exports; everything else in the
+ * library is built with hidden visibility.
+ */
+#define VCALENDAR_API __attribute__ ((visibility ("default")))
+
+/* Opaque parser context */
+typedef struct _VCAL VCAL;
+
+/* Bits in vcalendar_event.has, for what was found */
+enum {
+   VCALENDAR_HAS_START    =1<<0,
+   VCALENDAR_HAS_END      =1<<1,
+   VCALENDAR_HAS_SUMMARY  =1<<2,
+   VCALENDAR_HAS_LOCATION =1<<3,
+   VCALENDAR_HAS_ORG      =1<<4,
+   VCALENDAR_HAS_DESC     =1<<5,
+   VCALENDAR_HAS_SCHED    =1<<6
 };
 
-extern struct Global G;
+/* What was found in an event. Strings belong to the VCAL, and
+ * remain valid until the next call to vcalendar_parse() or
+ * vcalendar_free() on it.
+ */
+struct vcalendar_event {
+   unsigned has;
+
+   /* UTC */
+   time_t start,
+          end,
+          scheduled;
+
+   const char *summary,
+              *location,
+              *organizer,
+              *description;
+
+   unsigned nAttendees;
+};
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+VCALENDAR_API void
+vcalendar_version(int *major, int *minor, int *patch);
+/***********************************************
+ * Get the version of the library actually linked.
+ */
+
+VCALENDAR_API VCAL*
+vcalendar_new(void);
+/***********************************************
+ * Allocate a parser context. Each thread needs
+ * its own.
+ *
+ * returns - the context, or NULL for failure.
+ */
+
+VCALENDAR_API void
+vcalendar_free(VCAL *vc);
+/***********************************************
+ * Release a parser context.
+ */
+
+VCALENDAR_API void
+vcalendar_set_style(VCAL *vc, const char *bold, const char *rev, const char *normal);
+/***********************************************
+ * Set the terminal escape codes used to highlight
+ * rendered reports. NULL means no highlighting.
+ */
+
+VCALENDAR_API int
+vcalendar_add_zone(VCAL *vc, const char *zone);
+/***********************************************
+ * Render times in the POSIX timezone zone (e.g.
+ * "Europe/Berlin") instead of local time. Call
+ * once for each zone wanted; times are listed in
+ * every zone, in the order added. Since 0.4.
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+VCALENDAR_API void
+vcalendar_set_event_cb(VCAL *vc, int (*cb)(VCAL *vc, void *ctxt), void *ctxt);
+/***********************************************
+ * Have cb called with ctxt as soon as each VEVENT
+ * in the input has been parsed. From cb, the event
+ * can be examined with vcalendar_event(),
+ * vcalendar_attendee() and vcalendar_render();
+ * it is forgotten once cb returns. If cb returns
+ * -1, vcalendar_parse() stops and fails. Without
+ * a callback, only the last VEVENT is kept. Since
+ * 0.5.
+ */
+
+VCALENDAR_API int
+vcalendar_parse(VCAL *vc, const char *buf, size_t buf_len);
+/***********************************************
+ * Parse a vcalendar attachment from memory,
+ * replacing whatever was parsed before.
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+VCALENDAR_API int
+vcalendar_event(VCAL *vc, struct vcalendar_event *rtnBuf);
+/***********************************************
+ * Fill in rtnBuf with what vcalendar_parse() found.
+ *
+ * returns - 0 for success, -1 for error.
+ */
+
+VCALENDAR_API int
+vcalendar_attendee(VCAL *vc, unsigned ndx, const char **name, const char **email, int *is_required);
+/***********************************************
+ * Get attendee number ndx. Attendees are in the
+ * order they were found until a report is rendered,
+ * which sorts them by name. Any of the return
+ * pointers may be NULL.
+ *
+ * returns - 0 for success, -1 if ndx is out of range.
+ */
+
+VCALENDAR_API const char*
+vcalendar_render(VCAL *vc, size_t *len);
+/***********************************************
+ * Render the report for what vcalendar_parse()
+ * found. The buffer belongs to the VCAL, and is
+ * valid until the next call on it. If len is not
+ * NULL, the length of the report is stored there.
+ *
+ * returns - the report, or NULL for failure.
+ */
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
@@ -0,0 +1,160 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+
+#include "ez_libpthread.h"
+#include "util.h"
+#include "workpool.h"
+
+static void*
+worker_main(void *arg)
+/***********************************************
+ * Worker thread; claim jobs until the pool is closed
+ * and there is nothing left to do.
+ */
+{
+   WORKPOOL *self= arg;
+
+   ez_pthread_mutex_lock(&self->mtx);
+
+   /* Each worker gets its own index */
+   unsigned worker_ndx= self->nStarted++;
+
+   for(;;) {
+
+      /* Wait for something to do */
+      while(self->seq_claim == self->seq_tail && !self->is_closing)
+         ez_pthread_cond_wait(&self->work_cond, &self->mtx);
+
+      if(self->seq_claim == self->seq_tail)
+         break;
+
+      unsigned long seq= self->seq_claim++;
+      void *job= self->jobArr[seq % self->maxJobs];
+
+      /* Do the job without holding the lock */
+      ez_pthread_mutex_unlock(&self->mtx);
+      (*self->work_f)(job, worker_ndx);
+      ez_pthread_mutex_lock(&self->mtx);
+
+      self->doneArr[seq % self->maxJobs]= 1;
+
+      /* If another worker is handing back jobs, it will pick this one up */
+      if(self->is_emitting)
+         continue;
+
+      /* Hand back completed jobs, oldest first */
+      self->is_emitting= 1;
+      while(self->seq_head != self->seq_claim && self->doneArr[self->seq_head % self->maxJobs]) {
+
+         unsigned slot= self->seq_head % self->maxJobs;
+         void *done= self->jobArr[slot];
+         self->doneArr[slot]= 0;
+
+         ez_pthread_mutex_unlock(&self->mtx);
+         (*self->done_f)(done);
+         ez_pthread_mutex_lock(&self->mtx);
+
+         ++self->seq_head;
+         ez_pthread_cond_signal(&self->space_cond);
+      }
+      self->is_emitting= 0;
+   }
+   ez_pthread_mutex_unlock(&self->mtx);
+
+   return NULL;
+}
+
+WORKPOOL*
+WORKPOOL_constructor (
+      WORKPOOL *self,
+      unsigned nThreads,
+      unsigned maxJobs,
+      void (*work_f)(void *job, unsigned worker_ndx),
+      void (*done_f)(void *job)
+      )
+/***********************************************
+ * Construct a WORKPOOL, and start the worker threads.
+ */
+{
+   WORKPOOL *rtn= NULL;
+
+   if(!self) return NULL;
+   memset(self, 0, sizeof(*self));
+
+   if(pthread_mutex_init(&self->mtx, NULL) ||
+      pthread_cond_init(&self->work_cond, NULL) ||
+      pthread_cond_init(&self->space_cond, NULL))
+   {
+      eprintf("ERROR: cannot initialize pthread objects");
+      goto abort;
+   }
+
+   self->maxJobs= maxJobs;
+   self->work_f= work_f;
+   self->done_f= done_f;
+
+   if(!(self->jobArr= calloc(maxJobs, sizeof(*self->jobArr))) ||
+      !(self->doneArr= calloc(maxJobs, sizeof(*self->doneArr))) ||
+      !(self->tidArr= calloc(nThreads, sizeof(*self->tidArr))))
+   {
+      sys_eprintf("ERROR: calloc() failed");
+      goto abort;
+   }
+
+   for(; self->nThreads < nThreads; ++self->nThreads)
+      ez_pthread_create(self->tidArr + self->nThreads, NULL, worker_main, self);
+
+   rtn= self;
+abort:
+   return rtn;
+}
+
+void*
+WORKPOOL_destructor (WORKPOOL *self)
+/***********************************************
+ * Wait for all submitted jobs to be handed back to
+ * done_f, then stop the worker threads and destruct
+ * the WORKPOOL.
+ */
+{
+   ez_pthread_mutex_lock(&self->mtx);
+   self->is_closing= 1;
+   ez_pthread_cond_broadcast(&self->work_cond);
+   ez_pthread_mutex_unlock(&self->mtx);
+
+   unsigned i;
+   for(i= 0; i < self->nThreads; ++i)
+      ez_pthread_join(self->tidArr[i], NULL);
+
+   if(self->jobArr) free(self->jobArr);
+   if(self->doneArr) free(self->doneArr);
+   if(self->tidArr) free(self->tidArr);
+
+   pthread_cond_destroy(&self->space_cond);
+   pthread_cond_destroy(&self->work_cond);
+   pthread_mutex_destroy(&self->mtx);
+
+   return self;
+}
+
+void
+WORKPOOL_submit (WORKPOOL *self, void *job)
+/***********************************************
+ * Submit a job to the pool. Blocks while maxJobs
+ * jobs are already in flight.
+ */
+{
+   ez_pthread_mutex_lock(&self->mtx);
+
+   while(self->seq_tail - self->seq_head == self->maxJobs)
+      ez_pthread_cond_wait(&self->space_cond, &self->mtx);
+
+   unsigned slot= self->seq_tail % self->maxJobs;
+   self->jobArr[slot]= job;
+   self->doneArr[slot]= 0;
+   ++self->seq_tail;
+
+   ez_pthread_cond_signal(&self->work_cond);
+   ez_pthread_mutex_unlock(&self->mtx);
+}
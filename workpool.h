@@ -0,0 +1,99 @@
+/************************************************************
+ * Class to run jobs on a pool of worker threads. Completed
+ * jobs are handed back in the same order they were submitted.
+ */
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <pthread.h>
+
+typedef struct _WORKPOOL {
+
+   pthread_mutex_t mtx;
+
+   pthread_cond_t work_cond,  /* Signaled when a job is submitted */
+                  space_cond; /* Signaled when a slot is freed */
+
+   /* Ring of jobs in flight, indexed by sequence number */
+   void **jobArr;
+   char *doneArr;
+   unsigned maxJobs;
+
+   /* Sequence numbers of the oldest job not yet handed back,
+    * the next job to be claimed by a worker, and the next job
+    * to be submitted.
+    */
+   unsigned long seq_head,
+                 seq_claim,
+                 seq_tail;
+
+   /* Set while a worker is handing back completed jobs */
+   int is_emitting;
+
+   /* Set when no more jobs will be submitted */
+   int is_closing;
+
+   pthread_t *tidArr;
+   unsigned nThreads,
+            nStarted;
+
+   /* Called on a worker thread to do the job */
+   void (*work_f)(void *job, unsigned worker_ndx);
+
+   /* Called once for each job in submission order */
+   void (*done_f)(void *job);
+
+} WORKPOOL;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define WORKPOOL_create(p, nThreads, maxJobs, work_f, done_f) \
+  ((p)=(WORKPOOL_constructor((p)=malloc(sizeof(WORKPOOL)), nThreads, maxJobs, work_f, done_f) ? (p) : ( p ? realloc(WORKPOOL_destructor(p),0) : 0 )))
+WORKPOOL*
+WORKPOOL_constructor (
+      WORKPOOL *self,
+      unsigned nThreads,
+      unsigned maxJobs,
+      void (*work_f)(void *job, unsigned worker_ndx),
+      void (*done_f)(void *job)
+      );
+/***********************************************
+ * Construct a WORKPOOL, and start the worker threads.
+ *
+ * nThreads - how many worker threads to run.
+ * maxJobs - how many jobs may be in flight before
+ *    WORKPOOL_submit() blocks.
+ * work_f - does the job, called on a worker thread.
+ *    worker_ndx is unique to the thread, and less than
+ *    nThreads, so it may be used to index per-thread state.
+ * done_f - called once for each job in the order they
+ *    were submitted, one at a time.
+ * returns - pointer to the object, or NULL for failure.
+ */
+
+void*
+WORKPOOL_destructor (WORKPOOL *self);
+/***********************************************
+ * Wait for all submitted jobs to be handed back to
+ * done_f, then stop the worker threads and destruct
+ * the WORKPOOL.
+ */
+
+#define WORKPOOL_destroy(p) \
+  do {if(WORKPOOL_destructor(p)) {free(p); p= NULL;}} while(0)
+
+void
+WORKPOOL_submit (WORKPOOL *self, void *job);
+/***********************************************
+ * Submit a job to the pool. Blocks while maxJobs
+ * jobs are already in flight.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif